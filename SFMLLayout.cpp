@@ -108,8 +108,9 @@ void element::cropSpriteY(sf::Sprite &sprite, float top, float height)
 }
 
 
-void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
-	float framePosX, float framePosY, float frameWidth, float frameHeight)
+void element::drawRepeatedSprite(sf::RenderWindow &window,
+	sf::Sprite &sourceSprite, float framePosX, float framePosY,
+	float frameWidth, float frameHeight)
 {
 	sf::Sprite sprite(sourceSprite);
 	sf::FloatRect srcRect = sourceSprite.getGlobalBounds();
@@ -127,7 +128,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 			posY += height)
 		{
 			sprite.setPosition(posX, posY);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 	float fullSprRight = posX, fullSprBottom = posY;
 
@@ -141,7 +142,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 		for (posY = fullSprTop ; posY < fullSprBottom ; posY += height)
 		{
 			sprite.setPosition(framePosX, posY);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 		if (fullSprTop > framePosY)
 		{
@@ -149,7 +150,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 			sf::Sprite sprite(sprite);
 			sprite.setPosition(framePosX, fullSprTop - height);
 			cropSpriteY(sprite, framePosY, fullSprTop - framePosY);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 		if (fullSprTop > framePosY)
 		{
@@ -158,7 +159,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 			sprite.setPosition(framePosX, fullSprBottom);
 			cropSpriteY(sprite, fullSprBottom, framePosY + frameHeight
 				- fullSprBottom);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 	}
 	if (fullSprRight < framePosX + frameWidth)
@@ -171,7 +172,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 		for (posY = fullSprTop ; posY < fullSprBottom ; posY += height)
 		{
 			sprite.setPosition(fullSprRight, posY);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 		if (fullSprTop > framePosY)
 		{
@@ -179,7 +180,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 			sf::Sprite sprite(sprite);
 			sprite.setPosition(fullSprRight, fullSprTop - height);
 			cropSpriteY(sprite, framePosY, fullSprTop - framePosY);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 		if (fullSprTop > framePosY)
 		{
@@ -188,7 +189,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 			sprite.setPosition(fullSprRight, fullSprBottom);
 			cropSpriteY(sprite, fullSprBottom, framePosY + frameHeight
 				- fullSprBottom);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 	}
 	if (fullSprTop > framePosY)
@@ -200,7 +201,7 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 		for (posX = fullSprLeft ; posX < fullSprRight ; posX += width)
 		{
 			sprite.setPosition(posX, framePosY);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 	}
 	if (fullSprBottom < framePosY + frameHeight)
@@ -213,17 +214,18 @@ void element::drawRepeatedSprite(sf::Sprite &sourceSprite,
 		for (posX = fullSprLeft ; posX < fullSprRight ; posX += width)
 		{
 			sprite.setPosition(posX, fullSprBottom);
-			drawingWindow->draw(sprite);
+			window.draw(sprite);
 		}
 	}
 }
 
 
-void element::drawSprite(sf::Sprite &sprite, float framePosX, float framePosY,
-	float frameWidth, float frameHeight, DRAWMODE drawModeX, DRAWMODE drawModeY,
-	ALIGNMENT alignmentX, ALIGNMENT alignmentY)
+void element::drawSprite(sf::RenderWindow &window, sf::Sprite &sprite,
+	float framePosX, float framePosY, float frameWidth, float frameHeight,
+	DRAWMODE drawModeX, DRAWMODE drawModeY, ALIGNMENT alignmentX,
+	ALIGNMENT alignmentY)
 {
-	if (drawingWindow && sprite.getTexture())
+	if (sprite.getTexture())
 	{
 		sf::Sprite finalSprite(sprite);
 
@@ -264,16 +266,16 @@ void element::drawSprite(sf::Sprite &sprite, float framePosX, float framePosY,
 		// The sprite is drawn.
 		sf::FloatRect sprRect = finalSprite.getGlobalBounds();
 		if (drawModeX == repeat && drawModeY == repeat)
-			drawRepeatedSprite(finalSprite, framePosX, framePosY, frameWidth,
-				frameHeight);
+			drawRepeatedSprite(window, finalSprite, framePosX, framePosY,
+				frameWidth, frameHeight);
 		else if (drawModeX == repeat)
-			drawRepeatedSprite(finalSprite, framePosX, sprRect.top, frameWidth,
-				sprRect.height);
+			drawRepeatedSprite(window, finalSprite, framePosX, sprRect.top,
+				frameWidth, sprRect.height);
 		else if (drawModeY == repeat)
-			drawRepeatedSprite(finalSprite, sprRect.left, framePosY,
+			drawRepeatedSprite(window, finalSprite, sprRect.left, framePosY,
 				sprRect.width, frameHeight);
 		else
-			drawingWindow->draw(finalSprite);
+			window.draw(finalSprite);
 	}
 }
 
@@ -305,6 +307,8 @@ element::element(sf::RenderWindow* drawingWindow, sf::Sprite* background,
 	this->backgroundAlignmentX = backgroundAlignmentX;
 	this->backgroundAlignmentY = backgroundAlignmentY;
 	this->backgroundVisible = backgroundVisible;
+	displayIndex = -1;
+	extension = this;
 }
 
 
@@ -358,6 +362,7 @@ bool element::get_background_visibility()
 void element::set_drawing_window(sf::RenderWindow &drawingWindow)
 {
 	this->drawingWindow = &drawingWindow;
+	markAppearanceChanged();
 }
 
 
@@ -370,6 +375,7 @@ void element::r_set_drawing_window(sf::RenderWindow &drawingWindow)
 void element::set_background(sf::Sprite &background)
 {
 	this->background = &background;
+	markAppearanceChanged();
 }
 
 
@@ -378,6 +384,7 @@ void element::set_background_mode_x(DRAWMODE backgroundModeX)
 	if (backgroundModeX == crop || backgroundModeX == adjust ||
 		backgroundModeX == repeat)
 		this->backgroundModeX = backgroundModeX;
+	markAppearanceChanged();
 }
 
 
@@ -386,6 +393,7 @@ void element::set_background_mode_y(DRAWMODE backgroundModeY)
 	if (backgroundModeY == crop || backgroundModeY == adjust ||
 		backgroundModeY == repeat)
 		this->backgroundModeY = backgroundModeY;
+	markAppearanceChanged();
 }
 
 
@@ -397,6 +405,7 @@ void element::set_background_mode(DRAWMODE backgroundModeX, DRAWMODE backgroundM
 	if (backgroundModeY == crop || backgroundModeY == adjust ||
 		backgroundModeY == repeat)
 		this->backgroundModeY = backgroundModeY;
+	markAppearanceChanged();
 }
 
 
@@ -405,6 +414,7 @@ void element::set_background_alignment_x(ALIGNMENT backgroundAlignmentX)
 	if (backgroundAlignmentX == left || backgroundAlignmentX == right ||
 		backgroundAlignmentX == center)
 		this->backgroundAlignmentX = backgroundAlignmentX;
+	markAppearanceChanged();
 }
 
 
@@ -413,6 +423,7 @@ void element::set_background_alignment_y(ALIGNMENT backgroundAlignmentY)
 	if (backgroundAlignmentY == top || backgroundAlignmentY == bottom ||
 		backgroundAlignmentY == center)
 		this->backgroundAlignmentY = backgroundAlignmentY;
+	markAppearanceChanged();
 }
 
 
@@ -425,12 +436,14 @@ void element::set_background_alignment(ALIGNMENT backgroundAlignmentX,
 	if (backgroundAlignmentY == top || backgroundAlignmentY == bottom ||
 		backgroundAlignmentY == center)
 		this->backgroundAlignmentY = backgroundAlignmentY;
+	markAppearanceChanged();
 }
 
 
 void element::set_background_visibility(bool backgroundVisible)
 {
 	this->backgroundVisible = backgroundVisible;
+	markAppearanceChanged();
 }
 
 
@@ -453,16 +466,50 @@ void element::r_copy(element &element)
 }
 
 
-void element::draw()
+void element::drawBackground()
 {
-	if (drawingWindow)
-	{
-		if (backgroundVisible && background)
-			drawSprite(*background, slotPosX, slotPosY, slotWidth, slotHeight,
-				backgroundModeX, backgroundModeY, backgroundAlignmentX,
-				backgroundAlignmentY);
-		baseElement::draw();
-	}
+	if (drawingWindow && backgroundVisible && background)
+		drawSprite(*drawingWindow, *background, slotPosX, slotPosY, slotWidth,
+			slotHeight, backgroundModeX, backgroundModeY, backgroundAlignmentX,
+			backgroundAlignmentY);
+}
+
+
+void element::markAppearanceChanged()
+{
+	if (geometry)
+		geometry->mark_changed(*this);
+}
+
+
+void element::fillSnapshotRecord(snapshotRecord &record)
+{
+	record.contentPosX = contentPosX;
+	record.contentPosY = contentPosY;
+	record.contentWidth = contentWidth;
+	record.contentHeight = contentHeight;
+	record.slotPosX = slotPosX;
+	record.slotPosY = slotPosY;
+	record.slotWidth = slotWidth;
+	record.slotHeight = slotHeight;
+	record.drawingWindow = drawingWindow;
+	record.contentVisible = get_content_visibility();
+	record.backgroundVisible = backgroundVisible;
+	record.background = background;
+	record.backgroundModeX = backgroundModeX;
+	record.backgroundModeY = backgroundModeY;
+	record.backgroundAlignmentX = backgroundAlignmentX;
+	record.backgroundAlignmentY = backgroundAlignmentY;
+	record.content = 0;
+}
+
+
+bool element::drawFrame()
+{
+	if (!drawingWindow)
+		return false;
+	drawBackground();
+	return true;
 }
 
 
@@ -471,15 +518,26 @@ void element::draw()
 
 void spriteElement::drawContent()
 {
-	if (content)
+	if (drawingWindow && content)
 	{
-		drawSprite(*content, contentPosX, contentPosY, contentWidth,
-			contentHeight, spriteModeX, spriteModeY, spriteAlignmentX,
-			spriteAlignmentY);
+		drawSprite(*drawingWindow, *content, contentPosX, contentPosY,
+			contentWidth, contentHeight, spriteModeX, spriteModeY,
+			spriteAlignmentX, spriteAlignmentY);
 	}
 }
 
 
+void spriteElement::fillSnapshotRecord(snapshotRecord &record)
+{
+	element::fillSnapshotRecord(record);
+	record.content = content;
+	record.contentModeX = spriteModeX;
+	record.contentModeY = spriteModeY;
+	record.contentAlignmentX = spriteAlignmentX;
+	record.contentAlignmentY = spriteAlignmentY;
+}
+
+
 spriteElement::spriteElement(sf::Sprite* content, std::string name,
 	float contentPosX, float contentPosY, float contentWidth,
 	float contentHeight, float slotPosX, float slotPosY, float slotWidth,
@@ -563,6 +621,7 @@ ALIGNMENT spriteElement::get_sprite_alignment_y()
 void spriteElement::set_content(sf::Sprite &content)
 {
 	this->content = &content;
+	markAppearanceChanged();
 }
 
 
@@ -570,6 +629,7 @@ void spriteElement::set_sprite_mode_x(DRAWMODE spriteModeX)
 {
 	if (spriteModeX == crop || spriteModeX == adjust || spriteModeX == repeat)
 		this->spriteModeX = spriteModeX;
+	markAppearanceChanged();
 }
 
 
@@ -577,6 +637,7 @@ void spriteElement::set_sprite_mode_y(DRAWMODE spriteModeY)
 {
 	if (spriteModeY == crop || spriteModeY == adjust || spriteModeY == repeat)
 		this->spriteModeY = spriteModeY;
+	markAppearanceChanged();
 }
 
 
@@ -586,6 +647,7 @@ void spriteElement::set_sprite_mode(DRAWMODE spriteModeX, DRAWMODE spriteModeY)
 		this->spriteModeX = spriteModeX;
 	if (spriteModeY == crop || spriteModeY == adjust || spriteModeY == repeat)
 		this->spriteModeY = spriteModeY;
+	markAppearanceChanged();
 }
 
 
@@ -594,6 +656,7 @@ void spriteElement::set_sprite_alignment_x(ALIGNMENT spriteAlignmentX)
 	if (spriteAlignmentX == left || spriteAlignmentX == right ||
 		spriteAlignmentX == center)
 		this->spriteAlignmentX = spriteAlignmentX;
+	markAppearanceChanged();
 }
 
 
@@ -602,6 +665,7 @@ void spriteElement::set_sprite_alignment_y(ALIGNMENT spriteAlignmentY)
 	if (spriteAlignmentY == top || spriteAlignmentY == bottom ||
 		spriteAlignmentY == center)
 		this->spriteAlignmentY = spriteAlignmentY;
+	markAppearanceChanged();
 }
 
 
@@ -614,6 +678,7 @@ void spriteElement::set_sprite_alignment(ALIGNMENT spriteAlignmentX,
 	if (spriteAlignmentY == top || spriteAlignmentY == bottom ||
 		spriteAlignmentY == center)
 		this->spriteAlignmentY = spriteAlignmentY;
+	markAppearanceChanged();
 }
 
 
@@ -659,10 +724,11 @@ freeLayout::freeLayout(std::string name, float contentPosX, float contentPosY,
 	sf::RenderWindow* drawingWindow, sf::Sprite* background,
 	DRAWMODE backgroundModeX, DRAWMODE backgroundModeY,
 	ALIGNMENT backgroundAlignmentX, ALIGNMENT backgroundAlignmentY,
-	bool backgroundVisible)
+	bool backgroundVisible, bool sparse)
 	// The constructor of 'baseFreeLayout' is called in order to to initialise
 	// its attributes.
-	: baseFreeLayout(size, defaultAlignmentX, defaultAlignmentY, elastic),
+	: baseFreeLayout(size, defaultAlignmentX, defaultAlignmentY, elastic,
+	sparse),
 	// The constructor of 'element' is called in order to to initialise its
 	// attributes.
 	element(drawingWindow, background, backgroundModeX, backgroundModeY,
@@ -689,20 +755,16 @@ freeLayout::~freeLayout()
 
 element* freeLayout::get_element(int slot)
 {
-	return dynamic_cast<element*>(baseFreeLayout::get_element(slot));
+	baseElement *e = baseFreeLayout::get_element(slot);
+	return as_element(e);
 }
 
 
 void freeLayout::r_set_drawing_window(sf::RenderWindow &drawingWindow)
 {
-	this->drawingWindow = &drawingWindow; 
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-		{
-			// All instances are 'element', but pointers are to 'baseElement'.
-			element* elem = dynamic_cast<element*>(elements[i]);
-			elem->r_set_drawing_window(drawingWindow);
-		}
+	// All instances are 'element', but pointers are to 'baseElement'.
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+		as_element(&*it)->set_drawing_window(drawingWindow);
 }
 
 
@@ -736,18 +798,36 @@ void freeLayout::r_copy(freeLayout &layout)
 }
 
 
-element* freeLayout::find_element(int elementId)
+element* freeLayout::find_element(long long elementId)
 {
-	return dynamic_cast<element*>(baseFreeLayout::find_element(elementId));
+	baseElement *e = baseFreeLayout::find_element(elementId);
+	return as_element(e);
 }
 
 
-element* freeLayout::find_element(std::string elementName)
+element* freeLayout::find_element(const std::string &elementName)
 {
-	return dynamic_cast<element*>(baseFreeLayout::find_element(elementName));
+	baseElement *e = baseFreeLayout::find_element(elementName);
+	return as_element(e);
 }
 
 
+element* freeLayout::find_element(const char *elementName)
+{
+	baseElement *e = baseFreeLayout::find_element(elementName);
+	return as_element(e);
+}
+
+
+#ifdef LAYOUT_STRING_VIEW
+element* freeLayout::find_element(std::string_view elementName)
+{
+	baseElement *e = baseFreeLayout::find_element(elementName);
+	return as_element(e);
+}
+#endif
+
+
 void freeLayout::add_element(element &element)
 {
 	baseFreeLayout::add_element(element, lowestEmptySlot);
@@ -760,9 +840,25 @@ void freeLayout::add_element(element &element, int slot)
 }
 
 
+void freeLayout::add_elements(const std::vector<element*> &newElements)
+{
+	std::vector<baseElement*> e(newElements.begin(), newElements.end());
+	baseFreeLayout::add_elements(e);
+}
+
+
+void freeLayout::add_elements(const std::vector<element*> &newElements,
+	int slot)
+{
+	std::vector<baseElement*> e(newElements.begin(), newElements.end());
+	baseFreeLayout::add_elements(e, slot);
+}
+
+
 element* freeLayout::remove_element(int slot)
 {
-	return dynamic_cast<element*>(baseFreeLayout::remove_element(slot));
+	baseElement *e = baseFreeLayout::remove_element(slot);
+	return as_element(e);
 }
 
 
@@ -897,6 +993,17 @@ verticalLayout* verticalLayout::r_clone()
 /* CLASS tableLayout */
 
 
+baseElement* tableLayout::createCell()
+{
+	baseElement *cell = baseTableLayout::createCell();
+	// All instances are 'element', but pointers are to 'baseElement'.
+	element *cellElement = as_element(cell);
+	if (!cellElement->get_drawing_window() && drawingWindow)
+		cellElement->r_set_drawing_window(*drawingWindow);
+	return cell;
+}
+
+
 tableLayout::tableLayout(std::string name, float contentPosX,
 	float contentPosY, float contentWidth, float contentHeight, float slotPosX,
 	float slotPosY, float slotWidth, float slotHeight, ALIGNMENT alignmentX,
@@ -945,7 +1052,21 @@ tableLayout::~tableLayout()
 
 element* tableLayout::get_element(int row, int column)
 {
-	return dynamic_cast<element*>(baseTableLayout::get_element(row, column));
+	baseElement *e = baseTableLayout::get_element(row, column);
+	return as_element(e);
+}
+
+
+element* tableLayout::get_cell_prototype()
+{
+	baseElement *e = baseTableLayout::get_cell_prototype();
+	return as_element(e);
+}
+
+
+void tableLayout::set_cell_prototype(element &cellPrototype)
+{
+	baseTableLayout::set_cell_prototype(cellPrototype);
 }
 
 
@@ -985,9 +1106,436 @@ void tableLayout::add_element(element &element, int row, int column)
 }
 
 
+void tableLayout::add_elements(const std::vector<element*> &newElements,
+	int row, int column)
+{
+	std::vector<baseElement*> e(newElements.begin(), newElements.end());
+	baseTableLayout::add_elements(e, row, column);
+}
+
+
 element* tableLayout::remove_element(int row, int column)
 {
-	return dynamic_cast<element*>(
-		baseTableLayout::remove_element(row, column));
+	baseElement *e = baseTableLayout::remove_element(row, column);
+	return as_element(e);
+}
+
+
+/* CLASS listLayout */
+
+
+baseElement* listLayout::createRow()
+{
+	baseElement *row = baseListLayout::createRow();
+	// All instances are 'element', but pointers are to 'baseElement'.
+	element *rowElement = as_element(row);
+	if (!rowElement->get_drawing_window() && drawingWindow)
+		rowElement->r_set_drawing_window(*drawingWindow);
+	return row;
+}
+
+
+listLayout::listLayout(std::string name, float contentPosX, float contentPosY,
+	float contentWidth, float contentHeight, float slotPosX, float slotPosY,
+	float slotWidth, float slotHeight, ALIGNMENT alignmentX,
+	ALIGNMENT alignmentY, int depth, bool visible, bool contentVisible,
+	std::map<std::string, event*> &events, bool horizontal, int itemCount,
+	float itemExtent, ALIGNMENT defaultAlignmentX, ALIGNMENT defaultAlignmentY,
+	sf::RenderWindow* drawingWindow, sf::Sprite* background,
+	DRAWMODE backgroundModeX, DRAWMODE backgroundModeY,
+	ALIGNMENT backgroundAlignmentX, ALIGNMENT backgroundAlignmentY,
+	bool backgroundVisible)
+	// The constructor of 'baseListLayout' is called in order to initialise its
+	// attributes.
+	: baseListLayout(horizontal, itemCount, itemExtent),
+	// The constructor of 'freeLayout' is called in order to initialise its
+	// attributes.
+	freeLayout(name, contentPosX, contentPosY, contentWidth,
+	contentHeight, slotPosX, slotPosY, slotWidth, slotHeight, alignmentX,
+	alignmentY, depth, visible, contentVisible, events, 0, defaultAlignmentX,
+	defaultAlignmentY, false, drawingWindow, background, backgroundModeX,
+	backgroundModeY, backgroundAlignmentX, backgroundAlignmentY,
+	backgroundVisible),
+	// 'freeLayout' and 'baseListLayout' inherit from 'baseFreeLayout'
+	// virtually, so its constructor must also be called here (or it wouldn't be
+	// called).
+	baseFreeLayout(0, defaultAlignmentX, defaultAlignmentY, false),
+	// 'freeLayout' and 'baseFreeLayout' inherit from 'baseElement' virtually,
+	// so its constructor must also be called here (or it wouldn't be called).
+	baseElement(name, contentPosX, contentPosY, contentWidth, contentHeight,
+	slotPosX, slotPosY, slotWidth, slotHeight, alignmentX, alignmentY, depth,
+	visible, contentVisible, events)
+{
+}
+
+
+listLayout::listLayout(listLayout &layout)
+{
+	layout.listLayout::copy(*this);
+}
+
+		
+listLayout::~listLayout()
+{
 }
 
+
+element* listLayout::get_row_prototype()
+{
+	baseElement *e = baseListLayout::get_row_prototype();
+	return as_element(e);
+}
+
+
+element* listLayout::get_row(int item)
+{
+	baseElement *e = baseListLayout::get_row(item);
+	return as_element(e);
+}
+
+
+void listLayout::set_row_prototype(element &rowPrototype)
+{
+	baseListLayout::set_row_prototype(rowPrototype);
+}
+
+
+listLayout* listLayout::clone()
+{
+	listLayout *newLayout = new listLayout();
+	copy(*newLayout);
+	return newLayout;
+}
+		
+
+listLayout* listLayout::r_clone()
+{
+	listLayout* newLayout = new listLayout();
+	r_copy(*newLayout);
+	return newLayout;
+}
+
+
+void listLayout::copy(listLayout &layout)
+{
+	baseListLayout::copy(layout);
+	freeLayout::copy(layout);
+}
+
+
+void listLayout::r_copy(listLayout &layout)
+{
+	baseListLayout::r_copy(layout);
+	freeLayout::copy(layout);
+}
+
+
+/* CLASS displayList */
+
+
+void displayList::appendSubtree(element &target)
+{
+	int index = records.size();
+	baseFreeLayout *layout = target.as_layout();
+	int previousIndex = target.displayIndex;
+	if (layout && !layout->get_draw_tree_dirty() && previousIndex >= 0 &&
+		previousIndex < previousRecords.size() &&
+		previousRecords[previousIndex].target == &target)
+	{
+		// The subtree hasn't changed, so its records are copied, moving them
+		// to their new position.
+		int offset = index - previousIndex;
+		for (int i = previousIndex ; i < previousRecords[previousIndex].end ;
+			i ++)
+		{
+			records.push_back(previousRecords[i]);
+			records.back().end += offset;
+			records.back().target->displayIndex = i + offset;
+		}
+		return;
+	}
+
+	drawRecord record;
+	record.target = &target;
+	record.isLayout = layout != 0;
+	record.end = index + 1;
+	records.push_back(record);
+	target.displayIndex = index;
+	if (layout)
+	{
+		std::vector<baseElement*> &order = layout->get_draw_order();
+		for (int i = 0 ; i < order.size() ; i ++)
+			// All instances are 'element', but pointers are to 'baseElement'.
+			appendSubtree(*as_element(order[i]));
+		records[index].end = records.size();
+		layout->clear_draw_tree_dirty();
+	}
+}
+
+
+displayList::displayList(freeLayout *root)
+{
+	this->root = root;
+	buildCount = 0;
+}
+
+
+freeLayout* displayList::get_root()
+{
+	return root;
+}
+
+
+void displayList::set_root(freeLayout &root)
+{
+	this->root = &root;
+	records.clear();
+}
+
+
+std::vector<drawRecord>& displayList::get_records()
+{
+	rebuild();
+	return records;
+}
+
+
+int displayList::get_build_count()
+{
+	return buildCount;
+}
+
+
+void displayList::rebuild()
+{
+	if (!root)
+		records.clear();
+	else if (records.empty() || records[0].target != root ||
+		root->get_draw_tree_dirty())
+	{
+		previousRecords.swap(records);
+		records.clear();
+		appendSubtree(*root);
+		previousRecords.clear();
+		buildCount ++;
+	}
+}
+
+
+void displayList::draw()
+{
+	if (root)
+	{
+		root->update_layout();
+		rebuild();
+		int i = 0;
+		while (i < records.size())
+		{
+			element &target = *records[i].target;
+			if (!target.drawingWindow)
+				i = records[i].end;
+			else
+			{
+				target.drawBackground();
+				if (!target.get_content_visibility())
+					i = records[i].end;
+				else if (records[i].isLayout)
+					i ++;
+				else
+				{
+					target.drawContent();
+					i = records[i].end;
+				}
+			}
+		}
+	}
+}
+
+
+/* CLASS layoutSnapshot */
+
+
+layoutSnapshot::layoutSnapshot()
+{
+	frame = 0;
+}
+
+
+const std::vector<snapshotRecord>& layoutSnapshot::get_records() const
+{
+	return records;
+}
+
+
+int layoutSnapshot::get_frame() const
+{
+	return frame;
+}
+
+
+void layoutSnapshot::draw() const
+{
+	int i = 0;
+	while (i < records.size())
+	{
+		const snapshotRecord &record = records[i];
+		if (!record.drawingWindow)
+			i = record.end;
+		else
+		{
+			if (record.backgroundVisible && record.background)
+				element::drawSprite(*record.drawingWindow, *record.background,
+					record.slotPosX, record.slotPosY, record.slotWidth,
+					record.slotHeight, record.backgroundModeX,
+					record.backgroundModeY, record.backgroundAlignmentX,
+					record.backgroundAlignmentY);
+			if (!record.contentVisible)
+				i = record.end;
+			else if (record.isLayout)
+				i ++;
+			else
+			{
+				if (record.content)
+					element::drawSprite(*record.drawingWindow, *record.content,
+						record.contentPosX, record.contentPosY,
+						record.contentWidth, record.contentHeight,
+						record.contentModeX, record.contentModeY,
+						record.contentAlignmentX, record.contentAlignmentY);
+				i = record.end;
+			}
+		}
+	}
+}
+
+
+/* CLASS snapshotBuffer */
+
+
+void snapshotBuffer::collectChanges()
+{
+	freeLayout *root = list.get_root();
+	geometryStore *store = root ? root->get_geometry_store() : 0;
+	if (store)
+	{
+		std::vector<drawRecord> &records = list.get_records();
+		const std::vector<int> &changes = store->get_changes();
+		for (int i = 0 ; i < changes.size() ; i ++)
+		{
+			baseElement *changed = store->get_element(changes[i]);
+			if (!changed)
+				continue;
+			// All instances are 'element', but pointers are to 'baseElement'.
+			element *target = as_element(changed);
+			int index = target->displayIndex;
+			if (index >= 0 && index < records.size() &&
+				records[index].target == target)
+				for (int j = 0 ; j < 3 ; j ++)
+					if (filledBuild[j] >= 0)
+						pendingRecords[j].push_back(index);
+		}
+		store->clear_changes();
+
+		// Past half of the records, filling them all is as fast.
+		for (int j = 0 ; j < 3 ; j ++)
+			if (pendingRecords[j].size() > records.size() / 2)
+			{
+				filledBuild[j] = -1;
+				pendingRecords[j].clear();
+			}
+	}
+}
+
+
+void snapshotBuffer::fillBack()
+{
+	std::vector<drawRecord> &records = list.get_records();
+	std::vector<snapshotRecord> &target = snapshots[back].records;
+	if (filledBuild[back] != list.get_build_count() ||
+		target.size() != records.size())
+	{
+		target.resize(records.size());
+		for (int i = 0 ; i < records.size() ; i ++)
+		{
+			records[i].target->fillSnapshotRecord(target[i]);
+			target[i].isLayout = records[i].isLayout;
+			target[i].end = records[i].end;
+		}
+	}
+	else
+		for (int i = 0 ; i < pendingRecords[back].size() ; i ++)
+		{
+			int index = pendingRecords[back][i];
+			records[index].target->fillSnapshotRecord(target[index]);
+		}
+	pendingRecords[back].clear();
+	filledBuild[back] = list.get_build_count();
+}
+
+
+snapshotBuffer::snapshotBuffer(freeLayout *root)
+{
+	for (int i = 0 ; i < 3 ; i ++)
+		filledBuild[i] = -1;
+	front = 0;
+	ready = 1;
+	back = 2;
+	readyIsNew = false;
+	frame = 0;
+	if (root)
+		set_root(*root);
+}
+
+
+freeLayout* snapshotBuffer::get_root()
+{
+	return list.get_root();
+}
+
+
+void snapshotBuffer::set_root(freeLayout &root)
+{
+	list.set_root(root);
+	if (!root.get_geometry_store())
+		root.r_set_geometry_store(ownStore);
+	for (int i = 0 ; i < 3 ; i ++)
+	{
+		filledBuild[i] = -1;
+		pendingRecords[i].clear();
+	}
+}
+
+
+void snapshotBuffer::publish()
+{
+	freeLayout *root = list.get_root();
+	if (root)
+		root->update_layout();
+	list.rebuild();
+	collectChanges();
+	fillBack();
+	frame ++;
+	snapshots[back].frame = frame;
+
+	std::lock_guard<std::mutex> lock(swapMutex);
+	std::swap(back, ready);
+	readyIsNew = true;
+}
+
+
+const layoutSnapshot& snapshotBuffer::acquire()
+{
+	std::lock_guard<std::mutex> lock(swapMutex);
+	if (readyIsNew)
+	{
+		std::swap(front, ready);
+		readyIsNew = false;
+	}
+	return snapshots[front];
+}
+
+
+element* LAYOUT::as_element(baseElement *e)
+{
+	// Only 'element' sets the extension of elements.
+	return e ? static_cast<element*>(e->get_extension()) : 0;
+}
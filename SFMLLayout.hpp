@@ -54,6 +54,12 @@ namespace LAYOUT
 	};
 
 
+	/*
+	- Incomplete declaration. Needed in class 'element' (declared first).
+	*/
+	struct snapshotRecord;
+
+
 	/*
 	- Base element expanded with SMFL-specific attributes and methods.
 	- It adds a window to draw on, a background sprite, and other attributes and
@@ -110,29 +116,35 @@ namespace LAYOUT
 		*/
 		bool contentVisible;
 
+		/*
+		- Position of the element's record in the display list that last
+		flattened it, or -1 if it has never been in one.
+		*/
+		int displayIndex;
+
 		/*
 		- Adjusts the position and size of a sprite on the X axis.
 		- The sprite MUSTN'T have a rotation component.
 		*/
-		void adjustSpriteX(sf::Sprite &sprite, float left, float width);
+		static void adjustSpriteX(sf::Sprite &sprite, float left, float width);
 
 		/*
 		- Adjusts the position and size of a sprite on the Y axis.
 		- The sprite MUSTN'T have a rotation component.
 		*/
-		void adjustSpriteY(sf::Sprite &sprite, float top, float height);
+		static void adjustSpriteY(sf::Sprite &sprite, float top, float height);
 
 		/*
 		- Crops a sprite on the X axis so it fits within the given space.
 		- The sprite MUSTN'T have a rotation component.
 		*/
-		void cropSpriteX(sf::Sprite &sprite, float left, float width);
+		static void cropSpriteX(sf::Sprite &sprite, float left, float width);
 
 		/*
 		- Crops a sprite on the Y axis so it fits within the given space.
 		- The sprite MUSTN'T have a rotation component.
 		*/
-		void cropSpriteY(sf::Sprite &sprite, float top, float height);
+		static void cropSpriteY(sf::Sprite &sprite, float top, float height);
 
 		/*
 		- Repeatedly draws the given sprite covering the specified rectangle.
@@ -143,16 +155,44 @@ namespace LAYOUT
 		- The sprite MUST be positioned in its entirety within the rectangle.
 		- The sprite MUSTN'T have a rotation component.
 		*/
-		void drawRepeatedSprite(sf::Sprite &sourceSprite, float framePosX,
-			float framePosY, float frameWidth, float frameHeight);
+		static void drawRepeatedSprite(sf::RenderWindow &window,
+			sf::Sprite &sourceSprite, float framePosX, float framePosY,
+			float frameWidth, float frameHeight);
 
 		/*
-		- Draws the given sprite inside the given frame, according to the
-		value of the given drawing mode and alignment attributes.
+		- Draws the given sprite in the given window, inside the given frame,
+		according to the value of the given drawing mode and alignment
+		attributes.
 		*/
-		void drawSprite(sf::Sprite &sprite, float framePosX, float framePosY,
-			float frameWidth, float frameHeight, DRAWMODE drawModeX,
-			DRAWMODE drawModeY, ALIGNMENT alignmentX, ALIGNMENT alignmentY);
+		static void drawSprite(sf::RenderWindow &window, sf::Sprite &sprite,
+			float framePosX, float framePosY, float frameWidth,
+			float frameHeight, DRAWMODE drawModeX, DRAWMODE drawModeY,
+			ALIGNMENT alignmentX, ALIGNMENT alignmentY);
+
+		/*
+		- Draws the background sprite on the slot frame, if it's visible.
+		*/
+		void drawBackground();
+
+		/*
+		- Marks the element as changed in its geometry store (if any), so
+		snapshot buffers copy its new appearance.
+		*/
+		void markAppearanceChanged();
+
+		/*
+		- Copies everything needed to draw the element (but its position in
+		the display list) into the given snapshot record.
+		- Can be redefined in derived classes, which should also fill the
+		content fields of the record.
+		*/
+		virtual void fillSnapshotRecord(snapshotRecord &record);
+
+		/*
+		- Draws the background, if the element has a drawing window.
+		- Returns 'false' if it hasn't, so the content isn't drawn either.
+		*/
+		bool drawFrame();
 
 	public:
 
@@ -272,12 +312,32 @@ namespace LAYOUT
 		void r_copy(element &element);
 
 		/*
-		- Draws the element's background and content in the drawing window.
+		- Display lists draw elements directly and keep track of where each one
+		is recorded.
 		*/
-		void draw();
+		friend class displayList;
+
+		/*
+		- Snapshots draw sprites with the same methods elements use.
+		*/
+		friend class layoutSnapshot;
+
+		/*
+		- Snapshot buffers fill records from elements and look them up in the
+		display list.
+		*/
+		friend class snapshotBuffer;
 	};
 
 
+	/*
+	- Returns a pointer to an element as an 'element', or 0 if it isn't one
+	(or the pointer is null).
+	- Same as 'dynamic_cast<element*>', but faster.
+	*/
+	element* as_element(baseElement *e);
+
+
 	/*
 	- An element of a layout with SFML properties, encapsulating an SFML sprite.
 	- Destroying this element won't destroy the sprite in it.
@@ -322,6 +382,12 @@ namespace LAYOUT
 		*/
 		void drawContent();
 
+		/*
+		- Copies everything needed to draw the element, content sprite
+		included, into the given snapshot record.
+		*/
+		void fillSnapshotRecord(snapshotRecord &record);
+
 	public:
 
 		/*
@@ -450,6 +516,7 @@ namespace LAYOUT
 
 		/*
 		- Default constructor.
+		- 'sparse' selects sparse storage (see 'baseFreeLayout::sparse').
 		*/
 		freeLayout(std::string name = "", float contentPosX = 0,
 			float contentPosY = 0, float contentWidth = 0,
@@ -466,7 +533,7 @@ namespace LAYOUT
 			DRAWMODE backgroundModeY = adjust,
 			ALIGNMENT backgroundAlignmentX = left,
 			ALIGNMENT backgroundAlignmentY = top,
-			bool backgroundVisible = true);
+			bool backgroundVisible = true, bool sparse = false);
 
 		/*
 		- Copy constructor.
@@ -527,15 +594,33 @@ namespace LAYOUT
 		- It's a more concrete version of the same method in 'baseFreeLayout'
 		(which returns a pointer to 'baseElement').
 		*/
-		element* find_element(int elementId);
+		element* find_element(long long elementId);
+
+		/*
+		- Returns a pointer to the element in the layout (or in a sublayout)
+		with the given name.
+		- It's a more concrete version of the same method in 'baseFreeLayout'
+		(which returns a pointer to 'baseElement').
+		*/
+		element* find_element(const std::string &elementName);
+
+		/*
+		- Returns a pointer to the element in the layout (or in a sublayout)
+		with the given name.
+		- It's a more concrete version of the same method in 'baseFreeLayout'
+		(which returns a pointer to 'baseElement').
+		*/
+		element* find_element(const char *elementName);
 
+#ifdef LAYOUT_STRING_VIEW
 		/*
 		- Returns a pointer to the element in the layout (or in a sublayout)
 		with the given name.
 		- It's a more concrete version of the same method in 'baseFreeLayout'
 		(which returns a pointer to 'baseElement').
 		*/
-		element* find_element(std::string elementName);
+		element* find_element(std::string_view elementName);
+#endif
 
 		/*
 		- Adds a given element to the layout at the lowest free slot.
@@ -551,6 +636,21 @@ namespace LAYOUT
 		*/
 		void add_element(element &element, int slot);
 
+		/*
+		- Adds the given elements to the layout at the lowest free slots.
+		- It's a more concrete version of the same method in 'baseFreeLayout'
+		(which accepts any instances dervived from 'baseElement').
+		*/
+		void add_elements(const std::vector<element*> &newElements);
+
+		/*
+		- Adds the given elements to the layout at consecutive slots from the
+		specified one.
+		- It's a more concrete version of the same method in 'baseFreeLayout'
+		(which accepts any instances dervived from 'baseElement').
+		*/
+		void add_elements(const std::vector<element*> &newElements, int slot);
+
 		/*
 		- Removes an element from the layout at the given slot and returns it.
 		- It's a more concrete version of the same method in 'baseFreeLayout'
@@ -670,6 +770,9 @@ namespace LAYOUT
 
 	/*
 	- A table layout extended with SFML poperties.
+	- When virtualized, cells must be instances of 'element' (or derived), and
+	are cloned from the prototype with their drawing window (or the layout's,
+	if they have none).
 	*/
 	class tableLayout : public baseTableLayout, public freeLayout
 	{
@@ -680,6 +783,14 @@ namespace LAYOUT
 		*/
 		using baseFreeLayout::set_elasticity;
 
+	protected:
+
+		/*
+		- Creates a new cell by cloning the prototype, and gives it the layout's
+		drawing window if it has none.
+		*/
+		baseElement* createCell();
+
 	public:
 
 		/*
@@ -730,6 +841,18 @@ namespace LAYOUT
 		*/
 		element* get_element(int row, int column);
 
+		/*
+		- It's a more concrete version of the same method in 'baseTableLayout'
+		(which returns a pointer to 'baseElement').
+		*/
+		element* get_cell_prototype();
+
+		/*
+		- It's a more concrete version of the same method in 'baseTableLayout'
+		(which accepts any instance dervived from 'baseElement').
+		*/
+		void set_cell_prototype(element &cellPrototype);
+
 		/*
 		- Sets the attributes 'numberOfRows' and 'numberOfColumns'.
 		- Hides the method 'set_size(int size)' from 'freeLayout'.
@@ -775,6 +898,19 @@ namespace LAYOUT
 		*/
 		void add_element(element &element, int row, int column);
 
+		/*
+		- For the original overloads of 'add_elements'.
+		*/
+		using freeLayout::add_elements;
+
+		/*
+		- Calls 'add_elements' translating row and column to slot number.
+		- It's a more concrete version of the same method in 'baseTableLayout'
+		(which accepts any instances dervived from 'baseElement').
+		*/
+		void add_elements(const std::vector<element*> &newElements, int row,
+			int column);
+
 		/*
 		- For the original overloads of 'remove_element'.
 		*/
@@ -788,6 +924,442 @@ namespace LAYOUT
 		element* remove_element(int row, int column);
 	};
 
+
+	/*
+	- A list layout (see 'baseListLayout') with SFML properties.
+	- Rows must be instances of 'element' (or derived), and are cloned from the
+	prototype with their drawing window (or the layout's, if they have none).
+	*/
+	class listLayout : public baseListLayout, public freeLayout
+	{
+	private:
+
+		/*
+		- The methods for turning on elasticity and resizing are hidden.
+		*/
+		using baseFreeLayout::set_elasticity;
+		using baseFreeLayout::set_size;
+
+	protected:
+
+		/*
+		- Creates a new row by cloning the prototype, and gives it the layout's
+		drawing window if it has none.
+		*/
+		baseElement* createRow();
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		listLayout(std::string name = "", float contentPosX = 0,
+			float contentPosY = 0, float contentWidth = 0,
+			float contentHeight = 0, float slotPosX = 0, float slotPosY = 0,
+			float slotWidth = 0, float slotHeight = 0,
+			ALIGNMENT alignmentX = none, ALIGNMENT alignmentY = none,
+			int depth = 0, bool visible = true, bool contentVisible = true,
+			std::map<std::string, event*> &events =
+			std::map<std::string, event*>::map<std::string, event*>(),
+			bool horizontal = false, int itemCount = 0, float itemExtent = 0,
+			ALIGNMENT defaultAlignmentX = left,
+			ALIGNMENT defaultAlignmentY = top,
+			sf::RenderWindow* defaultWindow = 0, sf::Sprite* background = 0,
+			DRAWMODE backgroundModeX = adjust,
+			DRAWMODE backgroundModeY = adjust,
+			ALIGNMENT backgroundAlignmentX = left,
+			ALIGNMENT backgroundAlignmentY = top,
+			bool backgroundVisible = true);
+
+		/*
+		- Copy constructor.
+		*/
+		listLayout(listLayout &layout);
+
+		/*
+		- Default destructor.
+		*/
+		virtual ~listLayout();
+
+		/*
+		- It's a more concrete version of the same method in 'baseListLayout'
+		(which returns a pointer to 'baseElement').
+		*/
+		element* get_row_prototype();
+
+		/*
+		- It's a more concrete version of the same method in 'baseListLayout'
+		(which returns a pointer to 'baseElement').
+		*/
+		element* get_row(int item);
+
+		/*
+		- It's a more concrete version of the same method in 'baseListLayout'
+		(which accepts any instance dervived from 'baseElement').
+		*/
+		void set_row_prototype(element &rowPrototype);
+
+		/*
+		- Creates a copy of the current layout in a new instance.
+		- MUST be redefined in instantiable derived classes for their type.
+		*/
+		virtual listLayout* clone();
+		
+		/*
+		- Creates a recursive copy of the current layout in a new instance.
+		- MUST be redefined in instantiable derived classes for their type.
+		*/
+		virtual listLayout* r_clone();
+
+		/*
+		- Copies the current layout's attributes into the received one.
+		- Rows are not copied (see 'baseListLayout::copy').
+		- Can be redefined in derived classes.
+		*/
+		virtual void copy(listLayout &layout);
+		
+		/*
+		- Copies the current layout's attributes into the received one.
+		- Rows are also recursively cloned. Any existing pointers in the
+		received layout are lost.
+		- Can be redefined in derived classes.
+		*/
+		virtual void r_copy(listLayout &layout);
+	};
+
+
+	/*
+	- An entry of a display list, corresponding to a single element.
+	*/
+	struct drawRecord
+	{
+		/*
+		- The element drawn by this record.
+		*/
+		element *target;
+
+		/*
+		- 'true' if the element is a layout, in which case the records of its
+		visible elements follow this one.
+		*/
+		bool isLayout;
+
+		/*
+		- Position right after the last record of the element's subtree (the
+		position of the next record if the element isn't a layout).
+		*/
+		int end;
+	};
+
+
+	/*
+	- A whole layout tree flattened into a single array of records, in the same
+	order in which drawing the root layout would draw them.
+	- Records are sorted by their parent's order first, and by depth (from
+	greater to lesser) among the elements of each layout. Depth is still only
+	compared between elements of the same layout.
+	- It's rebuilt only for those subtrees whose structure, depth or visibility
+	have changed since the last time. Records of unchanged subtrees are copied
+	as they were.
+	- Drawing the list is equivalent to drawing the root layout, but it's done
+	in a single loop over the records instead of recursively.
+	- A layout tree should only be flattened by one display list.
+	*/
+	class displayList
+	{
+	protected:
+
+		/*
+		- The layout at the root of the flattened tree.
+		*/
+		freeLayout *root;
+
+		/*
+		- Records of the tree, in drawing order.
+		*/
+		std::vector<drawRecord> records;
+
+		/*
+		- Records of the previous build, kept while rebuilding.
+		*/
+		std::vector<drawRecord> previousRecords;
+
+		/*
+		- Number of times the records have been rebuilt.
+		*/
+		int buildCount;
+
+		/*
+		- Appends the records of the given element and, if it's a layout,
+		those of its visible elements.
+		- If the element is a layout whose subtree hasn't changed since the
+		previous build, its previous records are copied instead.
+		*/
+		void appendSubtree(element &target);
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		displayList(freeLayout *root = 0);
+
+		/*
+		- Returns the value of the attribute 'root'.
+		*/
+		freeLayout* get_root();
+
+		/*
+		- Sets the attribute 'root'. The list will be built again entirely.
+		*/
+		void set_root(freeLayout &root);
+
+		/*
+		- Returns the records of the tree, rebuilding them first if needed.
+		*/
+		std::vector<drawRecord>& get_records();
+
+		/*
+		- Returns the value of the attribute 'buildCount'.
+		- Records keep their positions while it doesn't change.
+		*/
+		int get_build_count();
+
+		/*
+		- Rebuilds the records of those subtrees that have changed.
+		*/
+		void rebuild();
+
+		/*
+		- Updates the root layout, rebuilds the list if needed and draws every
+		record in it.
+		- Elements without a drawing window are skipped, along with their
+		subtrees (as they would be by 'draw').
+		*/
+		void draw();
+	};
+
+
+	/*
+	- An entry of a layout snapshot, corresponding to a single element.
+	- It holds copies of everything needed to draw the element, except for the
+	sprites, which are referenced.
+	*/
+	struct snapshotRecord
+	{
+		/*
+		- Attributes 'contentPosX', 'contentPosY', 'contentWidth' and
+		'contentHeight' of the element.
+		*/
+		float contentPosX, contentPosY, contentWidth, contentHeight;
+
+		/*
+		- Attributes 'slotPosX', 'slotPosY', 'slotWidth' and 'slotHeight' of
+		the element.
+		*/
+		float slotPosX, slotPosY, slotWidth, slotHeight;
+
+		/*
+		- 'true' if the element is a layout, in which case the records of its
+		visible elements follow this one.
+		*/
+		bool isLayout;
+
+		/*
+		- Position right after the last record of the element's subtree.
+		*/
+		int end;
+
+		/*
+		- The window where the element is drawn, or null if it isn't.
+		*/
+		sf::RenderWindow *drawingWindow;
+
+		/*
+		- Visibility of the element's content and background.
+		*/
+		bool contentVisible, backgroundVisible;
+
+		/*
+		- The background sprite of the element, and how it's drawn.
+		*/
+		sf::Sprite *background;
+		DRAWMODE backgroundModeX, backgroundModeY;
+		ALIGNMENT backgroundAlignmentX, backgroundAlignmentY;
+
+		/*
+		- The content sprite of the element (null if it has none), and how it's
+		drawn.
+		*/
+		sf::Sprite *content;
+		DRAWMODE contentModeX, contentModeY;
+		ALIGNMENT contentAlignmentX, contentAlignmentY;
+	};
+
+
+	/*
+	- A layout tree as it was at a given frame, flattened into a single array
+	of records in drawing order (as in a display list).
+	- Snapshots don't reference elements, so they can be drawn in a different
+	thread while the tree is being modified. Sprites are referenced, though,
+	so they mustn't be modified while a snapshot using them is being drawn.
+	- Snapshots are filled by snapshot buffers, and can't be modified
+	otherwise.
+	*/
+	class layoutSnapshot
+	{
+	protected:
+
+		/*
+		- Records of the tree, in drawing order.
+		*/
+		std::vector<snapshotRecord> records;
+
+		/*
+		- Number of the frame the snapshot was published in.
+		*/
+		int frame;
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		layoutSnapshot();
+
+		/*
+		- Returns the value of the attribute 'records'.
+		*/
+		const std::vector<snapshotRecord>& get_records() const;
+
+		/*
+		- Returns the value of the attribute 'frame'.
+		*/
+		int get_frame() const;
+
+		/*
+		- Draws every record in the snapshot, as the display list it was
+		filled from would.
+		*/
+		void draw() const;
+
+		/*
+		- Snapshot buffers fill snapshots.
+		*/
+		friend class snapshotBuffer;
+	};
+
+
+	/*
+	- Publishes snapshots of a layout tree from the thread that modifies it
+	(the logic thread) to another one that draws them (the render thread).
+	- Three snapshots are kept: one being drawn, one ready to be drawn next,
+	and one being filled. Neither thread ever waits for the other, except
+	while they swap two snapshots.
+	- Only the records that have changed since a snapshot was last filled are
+	copied into it again, as long as the structure, depth and visibility of
+	the tree haven't changed (or it's copied entirely).
+	- Changes are tracked by the geometry store of the root layout. If the root
+	has none, the buffer adds the tree to its own store.
+	- The buffer clears the changes of that store every time it publishes, so
+	nothing else should rely on them.
+	*/
+	class snapshotBuffer
+	{
+	protected:
+
+		/*
+		- The tree flattened in drawing order.
+		*/
+		displayList list;
+
+		/*
+		- The store used to track changes when the root has none.
+		*/
+		geometryStore ownStore;
+
+		/*
+		- The snapshots, referred to by position below.
+		*/
+		layoutSnapshot snapshots[3];
+
+		/*
+		- Positions of the records that have changed since each snapshot was
+		last filled.
+		*/
+		std::vector<int> pendingRecords[3];
+
+		/*
+		- Build count of the display list each snapshot was last filled from,
+		or -1 if it has to be filled entirely.
+		*/
+		int filledBuild[3];
+
+		/*
+		- Positions of the snapshot being drawn, the one ready to be drawn
+		next and the one being filled.
+		*/
+		int front, ready, back;
+
+		/*
+		- 'true' if the ready snapshot hasn't been acquired yet.
+		*/
+		bool readyIsNew;
+
+		/*
+		- Number of the last published frame.
+		*/
+		int frame;
+
+		/*
+		- Guards the positions of the ready snapshot, and 'readyIsNew'.
+		*/
+		std::mutex swapMutex;
+
+		/*
+		- Adds the records of the elements that have changed in the geometry
+		store of the root to the pending records of every snapshot.
+		*/
+		void collectChanges();
+
+		/*
+		- Fills the back snapshot, either entirely or only its pending records.
+		*/
+		void fillBack();
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		snapshotBuffer(freeLayout *root = 0);
+
+		/*
+		- Returns the root of the published tree.
+		*/
+		freeLayout* get_root();
+
+		/*
+		- Sets the root of the published tree. The next snapshots will be
+		filled entirely.
+		*/
+		void set_root(freeLayout &root);
+
+		/*
+		- Updates the root layout, fills the back snapshot with its current
+		state and makes it ready to be acquired.
+		- Called from the logic thread, once per frame.
+		*/
+		void publish();
+
+		/*
+		- Returns the latest published snapshot.
+		- The snapshot won't be modified until 'acquire' is called again.
+		- Called from the render thread.
+		*/
+		const layoutSnapshot& acquire();
+	};
+
 };
 
 
@@ -0,0 +1,101 @@
+/*
+|------------------------------------------------------------------------------|
+|                             BENCHMARK_APPEND.CPP                             |
+|------------------------------------------------------------------------------|
+| - Measures how long it takes to append 100k elements to a free layout and to |
+| a vertical layout (and update them), adding them one by one with             |
+| 'add_element', reserving the slots first with 'reserve', or adding them all  |
+| at once with 'add_elements'.                                                 |
+| - Every way is run several times, and the fastest run is printed.            |
+|------------------------------------------------------------------------------|
+*/
+
+
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "SFMLLayout.hpp"
+
+
+/*
+- Number of elements appended, and of runs of every way.
+*/
+const int elementCount = 100000;
+const int runs = 5;
+
+
+/*
+- Ways of appending the elements.
+*/
+enum APPEND {oneByOne, reserved, allAtOnce};
+
+
+/*
+- Appends the elements to a new layout of the given type, contained in a free
+layout, and returns the time (in milliseconds) it takes, update included.
+*/
+template <class layoutType>
+double measure(std::vector<LAYOUT::element*> &elements, APPEND way)
+{
+	LAYOUT::freeLayout root("root", 0, 0, 800, 600, 0, 0, 800, 600);
+	layoutType layout("", 0, 0, 300, 600);
+	root.add_element(layout);
+
+	std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	if (way == allAtOnce)
+		layout.add_elements(elements);
+	else
+	{
+		if (way == reserved)
+			layout.reserve(elements.size());
+		for (int i = 0 ; i < elements.size() ; i ++)
+			layout.add_element(*elements[i]);
+	}
+	root.update_layout();
+	std::chrono::steady_clock::time_point end =
+		std::chrono::steady_clock::now();
+
+	// Elements are removed, so they can be appended again.
+	for (int i = 0 ; i < elements.size() ; i ++)
+		layout.remove_element(*elements[i]);
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+
+/*
+- Returns the time of the fastest of several runs of 'measure'.
+*/
+template <class layoutType>
+double fastest(std::vector<LAYOUT::element*> &elements, APPEND way)
+{
+	double best = measure<layoutType>(elements, way);
+	for (int i = 1 ; i < runs ; i ++)
+		best = std::min(best, measure<layoutType>(elements, way));
+	return best;
+}
+
+
+/*
+- Main function. Prints the results of every way and layout.
+*/
+int main()
+{
+	sf::Sprite sprite;
+	std::vector<LAYOUT::element*> elements;
+	for (int i = 0 ; i < elementCount ; i ++)
+		elements.push_back(new LAYOUT::spriteElement(&sprite,
+			i % 3 ? "" : "named", 0, 0, 10, 10));
+
+	const char *names[] = {"add_element", "reserve + add_element",
+		"add_elements"};
+	printf("%-24s %14s %14s\n", "", "free (ms)", "vertical (ms)");
+	for (int way = oneByOne ; way <= allAtOnce ; way ++)
+		printf("%-24s %14.2f %14.2f\n", names[way],
+			fastest<LAYOUT::freeLayout>(elements, APPEND(way)),
+			fastest<LAYOUT::verticalLayout>(elements, APPEND(way)));
+
+	for (int i = 0 ; i < elements.size() ; i ++)
+		delete elements[i];
+}
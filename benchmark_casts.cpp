@@ -0,0 +1,128 @@
+/*
+|------------------------------------------------------------------------------|
+|                             BENCHMARK_CASTS.CPP                              |
+|------------------------------------------------------------------------------|
+| - Measures how long it takes to tell layouts apart from other elements, and  |
+| to find the 'element' of a 'baseElement', with 'as_layout' and 'as_element'  |
+| compared to 'dynamic_cast'.                                                  |
+| - Elements are a mix of sprites and layouts of every kind, visited in a      |
+| shuffled order so that the type of the next one can't be predicted.          |
+|------------------------------------------------------------------------------|
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include "SFMLLayout.hpp"
+
+
+/*
+- Number of elements, and of times each one is visited.
+*/
+const int elementCount = 100000;
+const int repetitions = 100;
+
+
+/*
+- Returns the time (in nanoseconds per element) a function counting the
+layouts (or 'element' instances) among the elements takes. The count is
+stored in 'found'.
+*/
+double measure(int (*count)(std::vector<LAYOUT::baseElement*>&),
+	std::vector<LAYOUT::baseElement*> &elements, int &found)
+{
+	std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	found = 0;
+	for (int i = 0 ; i < repetitions ; i ++)
+		found += count(elements);
+	std::chrono::steady_clock::time_point end =
+		std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() /
+		repetitions / elements.size();
+}
+
+
+/*
+- Functions counting layouts or 'element' instances, one way or the other.
+*/
+int count_as_layout(std::vector<LAYOUT::baseElement*> &elements)
+{
+	int count = 0;
+	for (int i = 0 ; i < elements.size() ; i ++)
+		if (elements[i]->as_layout())
+			count ++;
+	return count;
+}
+
+int count_dynamic_cast_layout(std::vector<LAYOUT::baseElement*> &elements)
+{
+	int count = 0;
+	for (int i = 0 ; i < elements.size() ; i ++)
+		if (dynamic_cast<LAYOUT::baseFreeLayout*>(elements[i]))
+			count ++;
+	return count;
+}
+
+int count_as_element(std::vector<LAYOUT::baseElement*> &elements)
+{
+	int count = 0;
+	for (int i = 0 ; i < elements.size() ; i ++)
+		if (LAYOUT::as_element(elements[i])->get_background_visibility())
+			count ++;
+	return count;
+}
+
+int count_dynamic_cast_element(std::vector<LAYOUT::baseElement*> &elements)
+{
+	int count = 0;
+	for (int i = 0 ; i < elements.size() ; i ++)
+		if (dynamic_cast<LAYOUT::element*>(elements[i])->
+			get_background_visibility())
+			count ++;
+	return count;
+}
+
+
+/*
+- Main function. Prints the results of both ways of every cast.
+*/
+int main()
+{
+	std::vector<LAYOUT::baseElement*> elements;
+	for (int i = 0 ; i < elementCount ; i ++)
+		switch (i % 8)
+		{
+			case 0:
+				elements.push_back(new LAYOUT::freeLayout());
+				break;
+			case 1:
+				elements.push_back(new LAYOUT::horizontalLayout());
+				break;
+			case 2:
+				elements.push_back(new LAYOUT::verticalLayout());
+				break;
+			case 3:
+				elements.push_back(new LAYOUT::tableLayout());
+				break;
+			default:
+				elements.push_back(new LAYOUT::spriteElement());
+		}
+	for (int i = elements.size() - 1 ; i > 0 ; i --)
+		std::swap(elements[i], elements[rand() % (i + 1)]);
+
+	int found1, found2;
+	double fast = measure(count_as_layout, elements, found1);
+	double slow = measure(count_dynamic_cast_layout, elements, found2);
+	printf("as_layout    %6.2f ns    dynamic_cast %6.2f ns    (%s)\n", fast,
+		slow, found1 == found2 ? "same results" : "DIFFERENT RESULTS");
+	fast = measure(count_as_element, elements, found1);
+	slow = measure(count_dynamic_cast_element, elements, found2);
+	printf("as_element   %6.2f ns    dynamic_cast %6.2f ns    (%s)\n", fast,
+		slow, found1 == found2 ? "same results" : "DIFFERENT RESULTS");
+
+	for (int i = 0 ; i < elements.size() ; i ++)
+		delete elements[i];
+}
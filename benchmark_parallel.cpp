@@ -0,0 +1,99 @@
+/*
+|------------------------------------------------------------------------------|
+|                            BENCHMARK_PARALLEL.CPP                            |
+|------------------------------------------------------------------------------|
+| - Measures how long it takes to update a vertical layout holding 2000 rows   |
+| of 50 elements each (horizontal layouts) after it's resized, serially with   |
+| 'update_layout' and in parallel with pools of 2, 4 and 8 threads (and as     |
+| many as hardware threads).                                                   |
+| - The gain depends on the number of cores: pools with more threads than      |
+| cores can't be faster than the serial update.                                |
+|------------------------------------------------------------------------------|
+*/
+
+
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "SFMLLayout.hpp"
+
+
+/*
+- Number of rows and of elements per row, and of updates measured.
+*/
+const int rowCount = 2000;
+const int rowSize = 50;
+const int repetitions = 20;
+
+
+/*
+- Returns the average time (in milliseconds) an update of the layout takes,
+serial if the pool is null.
+*/
+double measure(LAYOUT::verticalLayout &layout, LAYOUT::threadPool *pool)
+{
+	std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	for (int i = 0 ; i < repetitions ; i ++)
+	{
+		layout.set_content_size(800 + i % 2, 600);
+		if (pool)
+			layout.update_layout(*pool);
+		else
+			layout.update_layout();
+	}
+	std::chrono::steady_clock::time_point end =
+		std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() /
+		repetitions;
+}
+
+
+/*
+- Main function. Prints the results of every number of threads.
+*/
+int main()
+{
+	LAYOUT::verticalLayout layout("", 0, 0, 800, 600, 0, 0, 800, 600);
+	std::vector<LAYOUT::horizontalLayout*> rows;
+	std::vector<LAYOUT::spriteElement*> elements;
+	for (int i = 0 ; i < rowCount ; i ++)
+	{
+		rows.push_back(new LAYOUT::horizontalLayout());
+		for (int j = 0 ; j < rowSize ; j ++)
+		{
+			elements.push_back(new LAYOUT::spriteElement());
+			elements.back()->set_content_size(1 + j % 5, 1 + j % 7);
+			elements.back()->set_alignment(LAYOUT::center, LAYOUT::center);
+		}
+	}
+	{
+		LAYOUT::updateScope scope(layout);
+		for (int i = 0 ; i < rowCount ; i ++)
+		{
+			layout.add_element(*rows[i]);
+			for (int j = 0 ; j < rowSize ; j ++)
+				rows[i]->add_element(*elements[i * rowSize + j]);
+		}
+	}
+
+	// The first updates place everything, and aren't measured.
+	measure(layout, 0);
+	double serial = measure(layout, 0);
+	printf("%-8s %10s %8s\n", "threads", "time (ms)", "speedup");
+	printf("%-8s %10.2f %8.2f\n", "serial", serial, 1.0);
+	int threads[] = {2, 4, 8, (int)std::thread::hardware_concurrency()};
+	for (int i = 0 ; i < 4 ; i ++)
+	{
+		LAYOUT::threadPool pool(threads[i]);
+		double parallel = measure(layout, &pool);
+		printf("%-8d %10.2f %8.2f\n", pool.get_number_of_threads(), parallel,
+			serial / parallel);
+	}
+
+	for (int i = 0 ; i < elements.size() ; i ++)
+		delete elements[i];
+	for (int i = 0 ; i < rows.size() ; i ++)
+		delete rows[i];
+}
@@ -0,0 +1,167 @@
+/*
+|------------------------------------------------------------------------------|
+|                             BENCHMARK_SLOTS.CPP                              |
+|------------------------------------------------------------------------------|
+| - Measures how long horizontal, vertical and table layouts take to           |
+| recalculate the slots of their elements and align their content, with 1k,    |
+| 10k and 100k elements.                                                       |
+| - Each layout is measured calculating all slots at once and aligning them    |
+| in bulk (the 'bulk' column) and going through its elements one by one, as    |
+| layouts that don't define 'calculateSlotRects' do (the 'per element'         |
+| column).                                                                     |
+| - The bulk kernels use SSE2 or AVX2 when available. Compiling with           |
+| 'LAYOUT_NO_SIMD' defined measures their scalar version instead.              |
+|------------------------------------------------------------------------------|
+*/
+
+
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include "SFMLLayout.hpp"
+
+
+/*
+- Events of every layout (none).
+*/
+std::map<std::string, LAYOUT::event*> noEvents;
+
+
+/*
+- Horizontal layout which can't calculate its slots at once, so it goes
+through its elements one by one.
+*/
+class perElementHorizontalLayout : public LAYOUT::horizontalLayout
+{
+protected:
+	bool calculateSlotRects(float * /*slotPosX*/, float * /*slotPosY*/,
+		float * /*slotWidth*/, float * /*slotHeight*/)
+	{
+		return false;
+	}
+public:
+	perElementHorizontalLayout(int size) :
+		LAYOUT::horizontalLayout("", 0, 0, 800, 600, 0, 0, 800, 600,
+		LAYOUT::none, LAYOUT::none, 0, true, true, noEvents, size) {}
+};
+
+
+/*
+- Same as 'perElementHorizontalLayout', for vertical layouts.
+*/
+class perElementVerticalLayout : public LAYOUT::verticalLayout
+{
+protected:
+	bool calculateSlotRects(float * /*slotPosX*/, float * /*slotPosY*/,
+		float * /*slotWidth*/, float * /*slotHeight*/)
+	{
+		return false;
+	}
+public:
+	perElementVerticalLayout(int size) :
+		LAYOUT::verticalLayout("", 0, 0, 800, 600, 0, 0, 800, 600,
+		LAYOUT::none, LAYOUT::none, 0, true, true, noEvents, size) {}
+};
+
+
+/*
+- Same as 'perElementHorizontalLayout', for table layouts.
+*/
+class perElementTableLayout : public LAYOUT::tableLayout
+{
+protected:
+	bool calculateSlotRects(float * /*slotPosX*/, float * /*slotPosY*/,
+		float * /*slotWidth*/, float * /*slotHeight*/)
+	{
+		return false;
+	}
+public:
+	perElementTableLayout(int rows, int columns) :
+		LAYOUT::tableLayout("", 0, 0, 800, 600, 0, 0, 800, 600,
+		LAYOUT::none, LAYOUT::none, 0, true, true, noEvents, rows, columns) {}
+};
+
+
+/*
+- Fills a layout with elements of every alignment, and returns the average
+time (in nanoseconds per element) it takes to update it after its content
+is resized.
+*/
+double measure(LAYOUT::freeLayout &layout,
+	std::vector<LAYOUT::spriteElement> &elements)
+{
+	LAYOUT::ALIGNMENT alignmentsX[] = {LAYOUT::none, LAYOUT::left,
+		LAYOUT::right, LAYOUT::center};
+	LAYOUT::ALIGNMENT alignmentsY[] = {LAYOUT::none, LAYOUT::top,
+		LAYOUT::bottom, LAYOUT::center};
+	{
+		LAYOUT::updateScope scope(layout);
+		for (int i = 0 ; i < elements.size() ; i ++)
+		{
+			elements[i].set_content_size(1 + i % 5, 1 + i % 7);
+			layout.add_element(elements[i], i);
+			elements[i].set_alignment(alignmentsX[i % 4],
+				alignmentsY[i / 4 % 4]);
+		}
+	}
+
+	int repetitions = 10000000 / elements.size();
+	std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	for (int i = 0 ; i < repetitions ; i ++)
+	{
+		layout.set_content_size(800 + i % 2, 600 + i % 2);
+		layout.update_layout();
+	}
+	std::chrono::steady_clock::time_point end =
+		std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() /
+		repetitions / elements.size();
+}
+
+
+/*
+- Main function. Prints the results of every layout and size.
+*/
+int main()
+{
+	int sizes[] = {1000, 10000, 100000};
+	printf("%-12s %8s %12s %18s\n", "layout", "elements", "bulk (ns)",
+		"per element (ns)");
+	for (int i = 0 ; i < 3 ; i ++)
+	{
+		int size = sizes[i];
+		double bulk, perElement;
+		{
+			std::vector<LAYOUT::spriteElement> elements1(size), elements2(size);
+			LAYOUT::horizontalLayout layout("", 0, 0, 800, 600, 0, 0, 800,
+				600, LAYOUT::none, LAYOUT::none, 0, true, true, noEvents, size);
+			perElementHorizontalLayout perElementLayout(size);
+			bulk = measure(layout, elements1);
+			perElement = measure(perElementLayout, elements2);
+			printf("%-12s %8d %12.2f %18.2f\n", "horizontal", size, bulk,
+				perElement);
+		}
+		{
+			std::vector<LAYOUT::spriteElement> elements1(size), elements2(size);
+			LAYOUT::verticalLayout layout("", 0, 0, 800, 600, 0, 0, 800, 600,
+				LAYOUT::none, LAYOUT::none, 0, true, true, noEvents, size);
+			perElementVerticalLayout perElementLayout(size);
+			bulk = measure(layout, elements1);
+			perElement = measure(perElementLayout, elements2);
+			printf("%-12s %8d %12.2f %18.2f\n", "vertical", size, bulk,
+				perElement);
+		}
+		{
+			std::vector<LAYOUT::spriteElement> elements1(size), elements2(size);
+			LAYOUT::tableLayout layout("", 0, 0, 800, 600, 0, 0, 800, 600,
+				LAYOUT::none, LAYOUT::none, 0, true, true, noEvents, size / 100,
+				100);
+			perElementTableLayout perElementLayout(size / 100, 100);
+			bulk = measure(layout, elements1);
+			perElement = measure(perElementLayout, elements2);
+			printf("%-12s %8d %12.2f %18.2f\n", "table", size, bulk,
+				perElement);
+		}
+	}
+}
@@ -25,9 +25,9 @@
 /*
 - Incomplete declarations for wrappers. More about this later.
 */
-void change_eye_wrapper(std::map<std::string, void*> &args);
-void show_dot_wrapper(std::map<std::string, void*> &args);
-void close_window_wrapper(std::map<std::string, void*> &args);
+void change_eye_wrapper(const LAYOUT::argumentView &args);
+void show_dot_wrapper(const LAYOUT::argumentView &args);
+void close_window_wrapper(const LAYOUT::argumentView &args);
 
 
 /*
@@ -113,16 +113,22 @@ public:
 		backgroundSprite.setTexture(backgroundTexture);
 
 		// All layouts are properly hierarchised and configured.
-		outerLayout.set_slot_size(800, 600);
-		outerLayout.set_default_alignment(LAYOUT::center, LAYOUT::center);
-		outerLayout.match_content_to_slot();
-		outerLayout.add_element(innerLeftLayout);
-		outerLayout.add_element(eyeElement);
-
-		innerLeftLayout.set_content_size(300, 400);
-		innerLeftLayout.add_element(prevLayout);
-		innerLeftLayout.add_element(nextLayout);
-		innerLeftLayout.add_element(quitElement);
+		// An update scope postpones slot recalculation and alignment until
+		// it's closed, when the whole layout is updated at once.
+		{
+			LAYOUT::updateScope scope(outerLayout);
+
+			outerLayout.set_slot_size(800, 600);
+			outerLayout.set_default_alignment(LAYOUT::center, LAYOUT::center);
+			outerLayout.match_content_to_slot();
+			outerLayout.add_element(innerLeftLayout);
+			outerLayout.add_element(eyeElement);
+
+			innerLeftLayout.set_content_size(300, 400);
+			innerLeftLayout.add_element(prevLayout);
+			innerLeftLayout.add_element(nextLayout);
+			innerLeftLayout.add_element(quitElement);
+		}
 
 		prevLayout.match_content_to_slot();
 		prevLayout.add_element(prevDotElement);
@@ -192,6 +198,9 @@ public:
 		handler.add_element(prevTextElement);
 		handler.add_element(nextTextElement);
 		handler.add_element(quitElement);
+		// With a spatial index, the handler can tell which elements are under
+		// the cursor without checking them all.
+		handler.set_spatial_index(64);
 
 		// Events are provided with condition and effect methods, and default
 		// arguments that will be passed on to them when activated.
@@ -288,9 +297,11 @@ public:
 		std::map<std::string, void*> condArgs;
 		condArgs["posX"] = &cursorPosX;
 		condArgs["posY"] = &cursorPosY;
-		// 'activate_events' has an optional third argument for extra effect
-		// arguments, but we don't need it now (default arguments are enough).
-		handler.activate_events("onClick", condArgs);
+		// 'activate_events_at' only checks the events of elements under the
+		// cursor, which is enough for conditions on the cursor position.
+		// It has an optional fifth argument for extra effect arguments, but we
+		// don't need it now (default arguments are enough).
+		handler.activate_events_at("onClick", cursorPosX, cursorPosY, condArgs);
 	}
 
 	/*
@@ -301,7 +312,7 @@ public:
 		std::map<std::string, void*> condArgs;
 		condArgs["posX"] = &cursorPosX;
 		condArgs["posY"] = &cursorPosY;
-		handler.activate_events("onHover", condArgs);
+		handler.activate_events_at("onHover", cursorPosX, cursorPosY, condArgs);
 	}
 };
 
@@ -319,36 +330,38 @@ static, or to use global wrappers, plus a global pointer to a class instance.
 - Next there are the wrappers for all event effect methods.
 - We can also use them for casting the required arguments to their original
 type (from void*) before passing them on to the appropropriate class method.
+- The arguments are received as a view, which looks them up among those passed
+on to 'activate_events' and then among the default ones. Functions receiving
+a map ('std::map<std::string, void*>&') can be used too, but the map has to be
+built on every activation.
 - It's a good practice to make sure that the arguments with the names we want
-exist in the map, but that can be omitted if we are certain that they do.
+exist in the view, but that can be omitted if we are certain that they do.
 */
 
 layoutExample *example_gp;
 
 
-void change_eye_wrapper(std::map<std::string, void*> &args)
+void change_eye_wrapper(const LAYOUT::argumentView &args)
 {
-	std::map<std::string, void*>::iterator it = args.find("move");
-	if (it != args.end())
+	if (args.has("move"))
 	{
-		int *move = static_cast<int*>(it->second);
+		int *move = static_cast<int*>(args.get("move"));
 		example_gp->change_eye(*move);
 	}
 }
 
 
-void show_dot_wrapper(std::map<std::string, void*> &args)
+void show_dot_wrapper(const LAYOUT::argumentView &args)
 {
-	std::map<std::string, void*>::iterator it = args.find("dot");
-	if (it != args.end())
+	if (args.has("dot"))
 	{
-		std::string *dot = static_cast<std::string*>(it->second);
+		std::string *dot = static_cast<std::string*>(args.get("dot"));
 		example_gp->show_dot(*dot);
 	}
 }
 
 
-void close_window_wrapper(std::map<std::string, void*> &args)
+void close_window_wrapper(const LAYOUT::argumentView &args)
 {
 	example_gp->close_window();
 }
@@ -15,14 +15,356 @@
 
 
 #include "layout.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Bulk slot and alignment calculations use AVX2 if the compiler targets it,
+// SSE2 otherwise (if available), and plain loops when neither is available or
+// 'LAYOUT_NO_SIMD' is defined. All of them give exactly the same results.
+#if !defined(LAYOUT_NO_SIMD) && defined(__AVX2__)
+#define LAYOUT_AVX2
+#include <immintrin.h>
+#elif !defined(LAYOUT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LAYOUT_SSE2
+#include <emmintrin.h>
+#endif
+
+// Slot bitsets scan and count bits with the compiler's builtins (or MSVC's
+// intrinsics) when available, and plain loops otherwise.
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__GNUC__)
+#define LAYOUT_MSVC_BITS
+#include <intrin.h>
+#endif
 
 using namespace LAYOUT;
 
 
+/* BULK CALCULATIONS */
+
+
+/*
+- Fills 'values' with 'start + i * step' for every position 'i' in it.
+*/
+static void fillSequence(float *values, int count, float start, float step)
+{
+	int i = 0;
+#if defined(LAYOUT_AVX2)
+	__m256 vStart = _mm256_set1_ps(start), vStep = _mm256_set1_ps(step);
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	for ( ; i + 8 <= count ; i += 8)
+	{
+		_mm256_storeu_ps(values + i, _mm256_add_ps(vStart,
+			_mm256_mul_ps(_mm256_cvtepi32_ps(index), vStep)));
+		index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+	}
+#elif defined(LAYOUT_SSE2)
+	__m128 vStart = _mm_set1_ps(start), vStep = _mm_set1_ps(step);
+	__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+	for ( ; i + 4 <= count ; i += 4)
+	{
+		_mm_storeu_ps(values + i, _mm_add_ps(vStart,
+			_mm_mul_ps(_mm_cvtepi32_ps(index), vStep)));
+		index = _mm_add_epi32(index, _mm_set1_epi32(4));
+	}
+#endif
+	for ( ; i < count ; i ++)
+		values[i] = start + i * step;
+}
+
+
+/*
+- Aligns the content of many elements on one axis at once, giving the same
+results as 'baseElement::align'.
+- 'alignStart' and 'alignEnd' are the alignment values for that axis ('left'
+and 'right', or 'top' and 'bottom'). Elements with any other alignment
+(other than 'center') keep their content position.
+- The new position is chosen between the candidates with masks instead of
+branching on the alignment.
+*/
+static void alignContent(int count, const float *slotPos,
+	const float *slotSize, const float *contentSize, const int *alignment,
+	float *contentPos, int alignStart, int alignEnd)
+{
+	int i = 0;
+#if defined(LAYOUT_AVX2)
+	__m256i vStart = _mm256_set1_epi32(alignStart);
+	__m256i vEnd = _mm256_set1_epi32(alignEnd);
+	__m256i vCenter = _mm256_set1_epi32(center);
+	__m256 half = _mm256_set1_ps(0.5f);
+	for ( ; i + 8 <= count ; i += 8)
+	{
+		__m256 pos = _mm256_loadu_ps(slotPos + i);
+		__m256 size = _mm256_loadu_ps(slotSize + i);
+		__m256 content = _mm256_loadu_ps(contentSize + i);
+		__m256i align = _mm256_loadu_si256((const __m256i*)(alignment + i));
+		__m256 atStart = _mm256_castsi256_ps(_mm256_cmpeq_epi32(align, vStart));
+		__m256 atEnd = _mm256_castsi256_ps(_mm256_cmpeq_epi32(align, vEnd));
+		__m256 atCenter =
+			_mm256_castsi256_ps(_mm256_cmpeq_epi32(align, vCenter));
+		__m256 endPos = _mm256_sub_ps(_mm256_add_ps(pos, size), content);
+		__m256 centerPos = _mm256_add_ps(pos,
+			_mm256_mul_ps(_mm256_sub_ps(size, content), half));
+		__m256 aligned = _mm256_or_ps(atStart, _mm256_or_ps(atEnd, atCenter));
+		__m256 result = _mm256_or_ps(
+			_mm256_or_ps(_mm256_and_ps(atStart, pos),
+			_mm256_and_ps(atEnd, endPos)),
+			_mm256_or_ps(_mm256_and_ps(atCenter, centerPos),
+			_mm256_andnot_ps(aligned, _mm256_loadu_ps(contentPos + i))));
+		_mm256_storeu_ps(contentPos + i, result);
+	}
+#elif defined(LAYOUT_SSE2)
+	__m128i vStart = _mm_set1_epi32(alignStart);
+	__m128i vEnd = _mm_set1_epi32(alignEnd);
+	__m128i vCenter = _mm_set1_epi32(center);
+	__m128 half = _mm_set1_ps(0.5f);
+	for ( ; i + 4 <= count ; i += 4)
+	{
+		__m128 pos = _mm_loadu_ps(slotPos + i);
+		__m128 size = _mm_loadu_ps(slotSize + i);
+		__m128 content = _mm_loadu_ps(contentSize + i);
+		__m128i align = _mm_loadu_si128((const __m128i*)(alignment + i));
+		__m128 atStart = _mm_castsi128_ps(_mm_cmpeq_epi32(align, vStart));
+		__m128 atEnd = _mm_castsi128_ps(_mm_cmpeq_epi32(align, vEnd));
+		__m128 atCenter = _mm_castsi128_ps(_mm_cmpeq_epi32(align, vCenter));
+		__m128 endPos = _mm_sub_ps(_mm_add_ps(pos, size), content);
+		__m128 centerPos = _mm_add_ps(pos,
+			_mm_mul_ps(_mm_sub_ps(size, content), half));
+		__m128 aligned = _mm_or_ps(atStart, _mm_or_ps(atEnd, atCenter));
+		__m128 result = _mm_or_ps(
+			_mm_or_ps(_mm_and_ps(atStart, pos), _mm_and_ps(atEnd, endPos)),
+			_mm_or_ps(_mm_and_ps(atCenter, centerPos),
+			_mm_andnot_ps(aligned, _mm_loadu_ps(contentPos + i))));
+		_mm_storeu_ps(contentPos + i, result);
+	}
+#endif
+	for ( ; i < count ; i ++)
+	{
+		float startPos = slotPos[i];
+		float endPos = slotPos[i] + slotSize[i] - contentSize[i];
+		float centerPos = slotPos[i] + (slotSize[i] - contentSize[i]) / 2;
+		contentPos[i] = alignment[i] == alignStart ? startPos :
+			alignment[i] == alignEnd ? endPos :
+			alignment[i] == center ? centerPos : contentPos[i];
+	}
+}
+
+
+/*
+- Checks which of many rectangles contain the given position, setting
+'inside' to 1 for those that do and to 0 for the others.
+- Bounds are included, giving the same results as
+'position_inside_slot_frame' and 'position_inside_content_frame'.
+*/
+static void testContainment(int count, const float *left, const float *top,
+	const float *right, const float *bottom, float posX, float posY,
+	unsigned char *inside)
+{
+	int i = 0;
+#if defined(LAYOUT_AVX2)
+	__m256 x = _mm256_set1_ps(posX), y = _mm256_set1_ps(posY);
+	for ( ; i + 8 <= count ; i += 8)
+	{
+		__m256 result = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(x, _mm256_loadu_ps(left + i), _CMP_GE_OQ),
+			_mm256_cmp_ps(x, _mm256_loadu_ps(right + i), _CMP_LE_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(y, _mm256_loadu_ps(top + i), _CMP_GE_OQ),
+			_mm256_cmp_ps(y, _mm256_loadu_ps(bottom + i), _CMP_LE_OQ)));
+		int mask = _mm256_movemask_ps(result);
+		for (int j = 0 ; j < 8 ; j ++)
+			inside[i + j] = (mask >> j) & 1;
+	}
+#elif defined(LAYOUT_SSE2)
+	__m128 x = _mm_set1_ps(posX), y = _mm_set1_ps(posY);
+	for ( ; i + 4 <= count ; i += 4)
+	{
+		__m128 result = _mm_and_ps(
+			_mm_and_ps(_mm_cmpge_ps(x, _mm_loadu_ps(left + i)),
+			_mm_cmple_ps(x, _mm_loadu_ps(right + i))),
+			_mm_and_ps(_mm_cmpge_ps(y, _mm_loadu_ps(top + i)),
+			_mm_cmple_ps(y, _mm_loadu_ps(bottom + i))));
+		int mask = _mm_movemask_ps(result);
+		for (int j = 0 ; j < 4 ; j ++)
+			inside[i + j] = (mask >> j) & 1;
+	}
+#endif
+	for ( ; i < count ; i ++)
+		inside[i] = posX >= left[i] && posX <= right[i] && posY >= top[i] &&
+			posY <= bottom[i];
+}
+
+
+/* CLASS nameIndex */
+
+
+std::size_t nameIndex::hash(const char *name, std::size_t length)
+{
+	// FNV-1a.
+	std::size_t h = 2166136261u;
+	for (std::size_t i = 0 ; i < length ; i ++)
+		h = (h ^ (unsigned char)name[i]) * 16777619u;
+	return h;
+}
+
+
+bool nameIndex::has_name(baseElement &element, const char *name,
+	std::size_t length)
+{
+	return element.name.compare(0, std::string::npos, name, length) == 0;
+}
+
+
+const nameIndex::entryList nameIndex::noEntries;
+
+
+int nameIndex::get_size()
+{
+	return positions.size();
+}
+
+
+const nameIndex::entryList& nameIndex::find(std::size_t nameHash)
+{
+	std::unordered_map<std::size_t, entryList>::iterator it =
+		entries.find(nameHash);
+	return it == entries.end() ? noEntries : it->second;
+}
+
+
+void nameIndex::add(baseElement &element)
+{
+	if (!element.name.empty() && !positions.count(&element))
+	{
+		entryList &list = entries[element.nameHash];
+		positions[&element] = list.size();
+		list.push_back(&element);
+	}
+}
+
+
+void nameIndex::add(nameIndex &index)
+{
+	for (std::unordered_map<baseElement*, int>::iterator it =
+		index.positions.begin() ; it != index.positions.end() ; it ++)
+		add(*it->first);
+}
+
+
+void nameIndex::remove(baseElement &element)
+{
+	std::unordered_map<baseElement*, int>::iterator it =
+		positions.find(&element);
+	if (it == positions.end())
+		return;
+
+	// The last element in the list takes the place of the removed one.
+	entryList &list = entries[element.nameHash];
+	baseElement *last = list.back();
+	list[it->second] = last;
+	positions[last] = it->second;
+	list.pop_back();
+	positions.erase(&element);
+	if (list.empty())
+		entries.erase(element.nameHash);
+}
+
+
+void nameIndex::clear()
+{
+	entries.clear();
+	positions.clear();
+}
+
+
 /* CLASS baseElement */
 
 
-int baseElement::idGenerator = 0;
+std::vector<unsigned int> baseElement::idGenerations;
+
+
+std::vector<int> baseElement::freeIdIndices;
+
+
+std::atomic<baseElement::idSlot*> baseElement::idBlocks[
+	(idIndexMask >> idBlockBits) + 1];
+
+
+std::mutex baseElement::idMutex;
+
+
+void baseElement::acquireId(baseElement &element)
+{
+	std::lock_guard<std::mutex> lock(idMutex);
+	int index;
+	if (freeIdIndices.empty())
+	{
+		index = idGenerations.size();
+		if (index > idIndexMask)
+			throw std::length_error("LAYOUT: too many elements at once");
+		idGenerations.push_back(0);
+		if ((index & (idBlockSize - 1)) == 0)
+		{
+			idSlot *block = new idSlot[idBlockSize];
+			for (int i = 0 ; i < idBlockSize ; i ++)
+			{
+				block[i].id = -1;
+				block[i].element = 0;
+			}
+			idBlocks[index >> idBlockBits] = block;
+		}
+	}
+	else
+	{
+		index = freeIdIndices.back();
+		freeIdIndices.pop_back();
+	}
+	element.id = (long long) idGenerations[index] << idIndexBits | index;
+	// The element is set before the id, which readers check first.
+	idSlot &slot = idBlocks[index >> idBlockBits][index & (idBlockSize - 1)];
+	slot.element = &element;
+	slot.id = element.id;
+}
+
+
+void baseElement::releaseId(long long id)
+{
+	std::lock_guard<std::mutex> lock(idMutex);
+	int index = id & idIndexMask;
+	idSlot &slot = idBlocks[index >> idBlockBits][index & (idBlockSize - 1)];
+	slot.id = -1;
+	slot.element = 0;
+	idGenerations[index] ++;
+	freeIdIndices.push_back(index);
+}
+
+
+baseElement* baseElement::findById(long long elementId)
+{
+	if (elementId < 0)
+		return 0;
+	int index = elementId & idIndexMask;
+	idSlot *block = idBlocks[index >> idBlockBits];
+	if (!block)
+		return 0;
+
+	// The id is checked again after reading the element, in case the index
+	// was given to another element in the meantime.
+	idSlot &slot = block[index & (idBlockSize - 1)];
+	if (slot.id != elementId)
+		return 0;
+	baseElement *element = slot.element;
+	return slot.id == elementId ? element : 0;
+}
+
+
+std::atomic<int> baseElement::openUpdateScopes(0);
+
+
+std::atomic<int> baseElement::parallelUpdates(0);
+
+
+std::mutex baseElement::indexMutex;
 
 
 baseElement::baseElement(std::string name, float contentPosX, float contentPosY,
@@ -46,8 +388,11 @@ baseElement::baseElement(std::string name, float contentPosX, float contentPosY,
 		alignmentY != center)
 		alignmentY = none;
 
-	id = idGenerator ++;
+	acquireId(*this);
+	thisLayout = 0;
+	extension = 0;
 	this->name = name;
+	nameHash = nameIndex::hash(name.data(), name.size());
 	parentLayout = 0;
 	slotNumber = -1;
 	this->contentPosX = contentPosX;
@@ -65,22 +410,104 @@ baseElement::baseElement(std::string name, float contentPosX, float contentPosY,
 	this->contentVisible = contentVisible;
 	this->events =
 		std::map<std::string, event*>::map<std::string, event*>(events);
+	layoutDirty = false;
+	alignmentDirty = false;
+	alignmentDeferred = false;
+	boundsDirty = true;
+	geometry = 0;
+	geometryIndex = -1;
 	align();
 }
 
 
 baseElement::~baseElement()
 {
+	if (geometry)
+		geometry->remove_element(*this);
+	while (!handlers.empty())
+		handlers.back()->remove_element(*this);
+	releaseId(id);
+}
+
+
+void baseElement::markLayoutDirty()
+{
+	// Marking stops at the first layout already marked, since all the layouts
+	// containing it must be marked too.
+	for (baseElement *e = this ; e && !e->layoutDirty ; e = e->parentLayout)
+		e->layoutDirty = true;
+}
+
+
+void baseElement::markBoundsDirty()
+{
+	// As with 'markLayoutDirty', layouts already marked have their containing
+	// layouts marked too.
+	for (baseElement *e = this ; e && !e->boundsDirty ; e = e->parentLayout)
+		e->boundsDirty = true;
+}
+
+
+void baseElement::storeGeometry()
+{
+	markBoundsDirty();
+	std::unique_lock<std::mutex> lock(indexMutex, std::defer_lock);
+	if (parallelUpdates > 0 && (geometry || !handlers.empty()))
+		lock.lock();
+	if (geometry)
+		geometry->store(*this);
+	for (int i = 0 ; i < handlers.size() ; i ++)
+		if (handlers[i]->cellSize > 0)
+			handlers[i]->indexGeometry(*this);
+}
+
+
+void baseElement::applySlotBounds(float slotPosX, float slotPosY,
+	float slotWidth, float slotHeight, float contentPosX, float contentPosY)
+{
+	alignmentDeferred = true;
+	set_slot_position(slotPosX, slotPosY);
+	set_slot_size(slotWidth, slotHeight);
+	alignmentDeferred = false;
+	// Inside a suspended layout, alignment is postponed as usual. The given
+	// content position is only right if the slot was set as given.
+	if ((openUpdateScopes > 0 && is_updating()) ||
+		this->slotPosX != slotPosX || this->slotPosY != slotPosY ||
+		this->slotWidth != slotWidth || this->slotHeight != slotHeight)
+		align();
+	else
+	{
+		alignmentDirty = false;
+		set_content_position(contentPosX, contentPosY);
+	}
 }
 
 
-int baseElement::get_id()
+long long baseElement::get_id()
 {
 	return id;
 }
 
 
-std::string baseElement::get_name()
+bool baseElement::is_layout()
+{
+	return thisLayout != 0;
+}
+
+
+baseFreeLayout* baseElement::as_layout()
+{
+	return thisLayout;
+}
+
+
+void* baseElement::get_extension()
+{
+	return extension;
+}
+
+
+const std::string& baseElement::get_name()
 {
 	return name;
 }
@@ -98,51 +525,71 @@ int baseElement::get_slot_number()
 }
 
 
+geometryStore* baseElement::get_geometry_store()
+{
+	return geometry;
+}
+
+
+int baseElement::get_geometry_index()
+{
+	return geometryIndex;
+}
+
+
 float baseElement::get_content_position_x()
 {
+	updatePendingSlots();
 	return contentPosX;
 }
 
 
 float baseElement::get_content_position_y()
 {
+	updatePendingSlots();
 	return contentPosY;
 }
 
 
 float baseElement::get_content_width()
 {
+	updatePendingSlots();
 	return contentWidth;
 }
 
 
 float baseElement::get_content_height()
 {
+	updatePendingSlots();
 	return contentHeight;
 }
 
 
 float baseElement::get_slot_position_x()
 {
-	return contentPosX;
+	updatePendingSlots();
+	return slotPosX;
 }
 
 
 float baseElement::get_slot_position_y()
 {
-	return contentPosY;
+	updatePendingSlots();
+	return slotPosY;
 }
 
 
 float baseElement::get_slot_width()
 {
-	return contentWidth;
+	updatePendingSlots();
+	return slotWidth;
 }
 
 
 float baseElement::get_slot_height()
 {
-	return contentHeight;
+	updatePendingSlots();
+	return slotHeight;
 }
 
 
@@ -192,9 +639,34 @@ event* baseElement::find_event(std::string eventName)
 }
 
 
-void baseElement::set_name(std::string name)
+void baseElement::set_name(const std::string &name)
 {
+	// The element is removed from the indices under its old name first.
+	baseFreeLayout *layout = parentLayout ? parentLayout->indexingLayout() : 0;
+	if (layout)
+		layout->names.remove(*this);
+	for (int i = 0 ; i < handlers.size() ; i ++)
+		handlers[i]->names.remove(*this);
+
 	this->name = name;
+	nameHash = nameIndex::hash(name.data(), name.size());
+
+	if (layout)
+		layout->names.add(*this);
+	for (int i = 0 ; i < handlers.size() ; i ++)
+		handlers[i]->names.add(*this);
+}
+
+
+void baseElement::set_geometry_store(geometryStore &store)
+{
+	store.add_element(*this);
+}
+
+
+void baseElement::r_set_geometry_store(geometryStore &store)
+{
+	set_geometry_store(store);
 }
 
 
@@ -202,6 +674,7 @@ void baseElement::set_content_position(float contentPosX, float contentPosY)
 {
 	this->contentPosX = contentPosX;
 	this->contentPosY = contentPosY;
+	storeGeometry();
 }
 
 
@@ -211,6 +684,7 @@ void baseElement::set_content_size(float contentWidth, float contentHeight)
 		this->contentWidth = contentWidth;
 	if (contentHeight >= 0)
 		this->contentHeight = contentHeight;
+	storeGeometry();
 	align();
 }
 
@@ -219,7 +693,9 @@ void baseElement::set_slot_position(float slotPosX, float slotPosY)
 {
 	this->slotPosX = slotPosX;
 	this->slotPosY = slotPosY;
-	align();
+	storeGeometry();
+	if (!alignmentDeferred)
+		align();
 }
 
 
@@ -229,7 +705,9 @@ void baseElement::set_slot_size(float slotWidth, float slotHeight)
 		this->slotWidth = slotWidth;
 	if (slotHeight >= 0)
 		this->slotHeight = slotHeight;
-	align();
+	storeGeometry();
+	if (!alignmentDeferred)
+		align();
 }
 
 
@@ -261,21 +739,46 @@ void baseElement::r_match_slot_to_content()
 
 void baseElement::set_alignment_x(ALIGNMENT alignmentX)
 {
-	if (alignmentX == none || alignmentX == left || alignmentX == right ||
-		alignmentX == center)
-		this->alignmentX = alignmentX;
+	set_alignment(alignmentX, this->alignmentY);
 }
 
 
 void baseElement::set_alignment_y(ALIGNMENT alignmentY)
 {
-	if (alignmentY == none || alignmentY == top || alignmentY == bottom ||
-		alignmentY == center)
-		this->alignmentY = alignmentY;
+	set_alignment(this->alignmentX, alignmentY);
 }
 
 
 void baseElement::set_alignment(ALIGNMENT alignmentX, ALIGNMENT alignmentY)
+{
+	bool validX = alignmentX == none || alignmentX == left ||
+		alignmentX == right || alignmentX == center;
+	bool validY = alignmentY == none || alignmentY == top ||
+		alignmentY == bottom || alignmentY == center;
+	if ((validX && alignmentX != this->alignmentX) ||
+		(validY && alignmentY != this->alignmentY))
+		updatePendingSlots();
+	assignAlignment(alignmentX, alignmentY);
+}
+
+
+void baseElement::updatePendingSlots()
+{
+	if (is_updating())
+		return;
+	// The outermost layout with pending changes is updated, as its slots
+	// decide those of the layouts inside it.
+	baseFreeLayout *pending = 0;
+	for (baseFreeLayout *layout = parentLayout ; layout ;
+		layout = layout->parentLayout)
+		if (layout->slotsDirty || layout->alignmentDirty)
+			pending = layout;
+	if (pending)
+		pending->update_layout();
+}
+
+
+void baseElement::assignAlignment(ALIGNMENT alignmentX, ALIGNMENT alignmentY)
 {
 	if (alignmentX == none || alignmentX == left || alignmentX == right ||
 		alignmentX == center)
@@ -283,11 +786,21 @@ void baseElement::set_alignment(ALIGNMENT alignmentX, ALIGNMENT alignmentY)
 	if (alignmentY == none || alignmentY == top || alignmentY == bottom ||
 		alignmentY == center)
 		this->alignmentY = alignmentY;
+	storeGeometry();
 }
 
 
 void baseElement::align()
 {
+	// While updates are suspended, alignment is postponed.
+	if (is_updating())
+	{
+		alignmentDirty = true;
+		markLayoutDirty();
+		return;
+	}
+	alignmentDirty = false;
+
 	float newContentPosX = contentPosX;
 	float newContentPosY = contentPosY;
 
@@ -328,14 +841,36 @@ void baseElement::r_align(ALIGNMENT alignmentX, ALIGNMENT alignmentY)
 }
 
 
+bool baseElement::is_updating()
+{
+	// There's no need to look for suspended layouts if there are none.
+	return openUpdateScopes > 0 && parentLayout && parentLayout->is_updating();
+}
+
+
+void baseElement::update_layout()
+{
+	if (layoutDirty && !is_updating())
+	{
+		layoutDirty = false;
+		if (alignmentDirty)
+			align();
+	}
+}
+
+
 void baseElement::set_depth(int depth)
 {
+	if (depth != this->depth && parentLayout)
+		parentLayout->markDrawOrderDirty();
 	this->depth = depth;
 }
 
 
 void baseElement::set_visibility(bool visible)
 {
+	if (visible != this->visible && parentLayout)
+		parentLayout->markDrawOrderDirty();
 	this->visible = visible;
 }
 
@@ -343,31 +878,45 @@ void baseElement::set_visibility(bool visible)
 void baseElement::set_content_visibility(bool contentVisible)
 {
 	this->contentVisible = contentVisible;
+	if (geometry)
+		geometry->mark_changed(*this);
 }
 
 
 void baseElement::set_events(std::map<std::string, event*> &events)
 {
+	for (int i = 0 ; i < handlers.size() ; i ++)
+		for (std::map<std::string, event*>::iterator it = this->events.begin() ;
+			it != this->events.end() ; it ++)
+			handlers[i]->unsubscribe(*this, it->first);
 	this->events =
 		std::map<std::string, event*>::map<std::string, event*>(events);
+	for (int i = 0 ; i < handlers.size() ; i ++)
+		for (std::map<std::string, event*>::iterator it = this->events.begin() ;
+			it != this->events.end() ; it ++)
+			handlers[i]->subscribe(*this, it->first, *it->second);
 }
 
 
 void baseElement::add_event(std::string eventName, event &e)
 {
 	events[eventName] = &e;
+	for (int i = 0 ; i < handlers.size() ; i ++)
+		handlers[i]->subscribe(*this, eventName, e);
 }
 
 
 void baseElement::remove_event(std::string eventName)
 {
-	events.erase(eventName);
+	if (events.erase(eventName))
+		for (int i = 0 ; i < handlers.size() ; i ++)
+			handlers[i]->unsubscribe(*this, eventName);
 }
 
 
 void baseElement::copy(baseElement &element)
 {
-	element.name = name;
+	element.set_name(name);
 	element.contentPosX = contentPosX;
 	element.contentPosY = contentPosY;
 	element.contentWidth = contentWidth;
@@ -381,8 +930,8 @@ void baseElement::copy(baseElement &element)
 	element.depth = depth;
 	element.visible = visible;
 	element.contentVisible = contentVisible;
-	element.events =
-		std::map<std::string, event*>::map<std::string, event*>(events);
+	element.set_events(events);
+	element.storeGeometry();
 }
 
 
@@ -398,649 +947,3429 @@ void baseElement::r_delete()
 }
 
 
+bool baseElement::drawFrame()
+{
+	return true;
+}
+
+
 void baseElement::draw()
 {
-	if (contentVisible)
+	if (layoutDirty)
+		update_layout();
+	if (drawFrame() && contentVisible)
 		drawContent();
 }
 
 
-/* CLASS elementHandler */
+/* CLASS geometryStore */
 
 
-elementHandler::elementHandler()
+void geometryStore::markChanged(int index)
 {
+	if (!changedFlags[index])
+	{
+		changedFlags[index] = true;
+		changedIndices.push_back(index);
+	}
 }
 
 
-elementHandler::elementHandler(elementHandler &handler)
+void geometryStore::store(baseElement &element)
 {
-	idMap = handler.idMap;
+	int i = element.geometryIndex;
+	if (!changedFlags[i])
+		changedIndices.push_back(i);
+	changedFlags[i] = 2;
+	stale = true;
 }
 
 
-elementHandler::~elementHandler()
+void geometryStore::refresh()
 {
+	if (stale)
+	{
+		for (int j = 0 ; j < changedIndices.size() ; j ++)
+		{
+			int i = changedIndices[j];
+			if (i < changedFlags.size() && changedFlags[i] == 2)
+			{
+				baseElement &element = *elements[i];
+				contentPosX[i] = element.contentPosX;
+				contentPosY[i] = element.contentPosY;
+				contentWidth[i] = element.contentWidth;
+				contentHeight[i] = element.contentHeight;
+				slotPosX[i] = element.slotPosX;
+				slotPosY[i] = element.slotPosY;
+				slotWidth[i] = element.slotWidth;
+				slotHeight[i] = element.slotHeight;
+				alignmentX[i] = element.alignmentX;
+				alignmentY[i] = element.alignmentY;
+				changedFlags[i] = 1;
+			}
+		}
+		stale = false;
+	}
 }
 
 
-std::map<int, baseElement*> elementHandler::get_map()
+geometryStore::geometryStore() :
+	stale(false)
 {
-	return idMap;
 }
 
 
-void elementHandler::copy(elementHandler &handler)
+geometryStore::~geometryStore()
 {
-	handler.idMap = idMap;
+	for (int i = 0 ; i < elements.size() ; i ++)
+	{
+		elements[i]->geometry = 0;
+		elements[i]->geometryIndex = -1;
+		for (int j = 0 ; j < elements[i]->handlers.size() ; j ++)
+			elements[i]->handlers[j]->countStored(this, -1);
+	}
 }
 
 
-baseElement* elementHandler::find_element(int elementId)
+int geometryStore::get_size()
 {
-	baseElement *e = 0;
-	std::map<int, baseElement*>::iterator it = idMap.find(elementId);
-	if (it != idMap.end())
-		e = it->second;
-	return e;
+	return elements.size();
 }
 
 
-baseElement* elementHandler::find_element(std::string elementName)
+baseElement* geometryStore::get_element(int index)
 {
-	for (std::map<int, baseElement*>::iterator it = idMap.begin() ;
-		it != idMap.end() ; it ++)
-	{
-		if (it->second->get_name() == elementName)
-			return it->second;
-	}
-	return 0;
+	if (index >= 0 && index < elements.size())
+		return elements[index];
+	else
+		return 0;
 }
 
 
-void elementHandler::add_element(baseElement &element)
+const std::vector<float>& geometryStore::get_content_position_x()
 {
-	idMap.insert(std::pair<int, baseElement*>(element.get_id(), &element));
+	refresh();
+	return contentPosX;
 }
 
 
-void elementHandler::r_add_element(baseElement &element)
+const std::vector<float>& geometryStore::get_content_position_y()
 {
-	idMap.insert(std::pair<int, baseElement*>(element.get_id(), &element));
-	if (baseFreeLayout *layout = dynamic_cast<baseFreeLayout*>(&element))
-	{
-		std::vector<baseElement*> elements = layout->get_elements();
-		for (int i = 0 ; i < elements.size() ; i ++)
-			if (elements[i])
-				r_add_element(*elements[i]);
-	}
+	refresh();
+	return contentPosY;
 }
 
 
-void elementHandler::remove_element(baseElement &element)
+const std::vector<float>& geometryStore::get_content_width()
 {
-	idMap.erase(element.get_id());
+	refresh();
+	return contentWidth;
 }
 
 
-void elementHandler::r_remove_element(baseElement &element)
+const std::vector<float>& geometryStore::get_content_height()
 {
-	idMap.erase(element.get_id());
-	if (baseFreeLayout *layout = dynamic_cast<baseFreeLayout*>(&element))
-	{
-		std::vector<baseElement*> elements = layout->get_elements();
-		for (int i = 0 ; i < elements.size() ; i ++)
-			if (elements[i])
-				r_remove_element(*elements[i]);
-	}
+	refresh();
+	return contentHeight;
 }
 
 
-void elementHandler::activate_events(std::string eventName,
-	std::map<std::string, void*> &conditionArgs,
-	std::map<std::string, void*> &effectArgs)
+const std::vector<float>& geometryStore::get_slot_position_x()
 {
-	for (std::map<int, baseElement*>::iterator it = idMap.begin() ;
-		it != idMap.end() ; it ++)
-		if (event *e = it->second->find_event(eventName))
-			// There is an event in the element with the given name.
-			e->activate(conditionArgs, effectArgs);
+	refresh();
+	return slotPosX;
 }
 
 
-/* CLASS event */
-
-
-event::event(eventConditionType eventCondition, eventEffectType eventEffect,
-	std::map<std::string, void*> &defaultConditionArgs,
-	std::map<std::string, void*> &defaultEffectArgs)
+const std::vector<float>& geometryStore::get_slot_position_y()
 {
-	this->eventCondition = eventCondition;
-	this->eventEffect = eventEffect;
-	this->defaultConditionArgs =
-		std::map<std::string, void*>::map<std::string, void*>(
-		defaultConditionArgs);
-	this->defaultEffectArgs =
-		std::map<std::string, void*>::map<std::string, void*>(
-		defaultEffectArgs);
+	refresh();
+	return slotPosY;
 }
 
 
-event::eventConditionType event::get_event_condition()
+const std::vector<float>& geometryStore::get_slot_width()
 {
-	return eventCondition;
+	refresh();
+	return slotWidth;
 }
 
 
-event::eventEffectType event::get_event_effect()
+const std::vector<float>& geometryStore::get_slot_height()
 {
-	return eventEffect;
+	refresh();
+	return slotHeight;
 }
 
 
-std::map<std::string, void*>& event::get_default_condition_args()
+const std::vector<ALIGNMENT>& geometryStore::get_alignment_x()
 {
-	return defaultConditionArgs;
+	refresh();
+	return alignmentX;
 }
 
 
-std::map<std::string, void*>& event::get_default_effect_args()
+const std::vector<ALIGNMENT>& geometryStore::get_alignment_y()
 {
-	return defaultEffectArgs;
+	refresh();
+	return alignmentY;
 }
 
 
-void event::set_event_condition(eventConditionType eventCondition)
+void geometryStore::mark_changed(baseElement &element)
 {
-	this->eventCondition = eventCondition;
+	if (element.geometry == this)
+		markChanged(element.geometryIndex);
 }
 
 
-void event::set_event_effect(eventEffectType eventEffect)
+const std::vector<int>& geometryStore::get_changes()
 {
-	this->eventEffect = eventEffect;
+	return changedIndices;
 }
 
 
-void event::set_default_condition_args(
-	std::map<std::string, void*> &defaultConditionArgs)
+void geometryStore::clear_changes()
 {
-	this->defaultConditionArgs =
-		std::map<std::string, void*>::map<std::string, void*>(
-		defaultConditionArgs);
+	// Attributes not copied yet would be lost with their flags.
+	refresh();
+	for (int i = 0 ; i < changedIndices.size() ; i ++)
+		if (changedIndices[i] < changedFlags.size())
+			changedFlags[changedIndices[i]] = false;
+	changedIndices.clear();
 }
 
 
-void event::set_default_effect_args(
-	std::map<std::string, void*> &defaultConditionArgs)
+void geometryStore::add_element(baseElement &element)
 {
-	this->defaultEffectArgs =
-		std::map<std::string, void*>::map<std::string, void*>(
-		defaultEffectArgs);
+	if (element.geometry != this)
+	{
+		if (element.geometry)
+			element.geometry->remove_element(element);
+		element.geometry = this;
+		element.geometryIndex = elements.size();
+		elements.push_back(&element);
+		for (int i = 0 ; i < element.handlers.size() ; i ++)
+			element.handlers[i]->countStored(this, 1);
+		contentPosX.push_back(0);
+		contentPosY.push_back(0);
+		contentWidth.push_back(0);
+		contentHeight.push_back(0);
+		slotPosX.push_back(0);
+		slotPosY.push_back(0);
+		slotWidth.push_back(0);
+		slotHeight.push_back(0);
+		alignmentX.push_back(none);
+		alignmentY.push_back(none);
+		changedFlags.push_back(false);
+		store(element);
+	}
 }
 
 
-void event::add_default_condition_argument(std::string argName, void *argValue)
+void geometryStore::remove_element(baseElement &element)
 {
-	defaultConditionArgs[argName] = argValue;
+	if (element.geometry == this)
+	{
+		// The last element is moved to the removed element's index, so the
+		// arrays stay contiguous.
+		refresh();
+		int i = element.geometryIndex, last = elements.size() - 1;
+		elements[i] = elements[last];
+		elements[i]->geometryIndex = i;
+		contentPosX[i] = contentPosX[last];
+		contentPosY[i] = contentPosY[last];
+		contentWidth[i] = contentWidth[last];
+		contentHeight[i] = contentHeight[last];
+		slotPosX[i] = slotPosX[last];
+		slotPosY[i] = slotPosY[last];
+		slotWidth[i] = slotWidth[last];
+		slotHeight[i] = slotHeight[last];
+		alignmentX[i] = alignmentX[last];
+		alignmentY[i] = alignmentY[last];
+		// The moved element is marked as changed under its new index, and its
+		// old index dropped from the changes, as it's going out of range (and
+		// could be given to a new element before changes are cleared).
+		if (changedFlags[last])
+			changedIndices.erase(std::find(changedIndices.begin(),
+				changedIndices.end(), last));
+		changedFlags[last] = false;
+		if (i != last)
+			markChanged(i);
+		elements.pop_back();
+		contentPosX.pop_back();
+		contentPosY.pop_back();
+		contentWidth.pop_back();
+		contentHeight.pop_back();
+		slotPosX.pop_back();
+		slotPosY.pop_back();
+		slotWidth.pop_back();
+		slotHeight.pop_back();
+		alignmentX.pop_back();
+		alignmentY.pop_back();
+		changedFlags.pop_back();
+		element.geometry = 0;
+		element.geometryIndex = -1;
+		for (int j = 0 ; j < element.handlers.size() ; j ++)
+			element.handlers[j]->countStored(this, -1);
+	}
 }
 
 
-void event::add_default_effect_argument(std::string argName, void *argValue)
+void geometryStore::find_elements_at(float posX, float posY,
+	std::vector<int> &found)
 {
-	defaultEffectArgs[argName] = argValue;
+	refresh();
+	found.clear();
+	for (int i = 0 ; i < elements.size() ; i ++)
+	{
+		// Same tests as 'position_inside_slot_frame' and
+		// 'position_inside_content_frame', without branching on each one.
+		bool inSlot = (posX >= slotPosX[i]) &
+			(posX <= slotPosX[i] + slotWidth[i]) & (posY >= slotPosY[i]) &
+			(posY <= slotPosY[i] + slotHeight[i]);
+		bool inContent = (posX >= contentPosX[i]) &
+			(posX <= contentPosX[i] + contentWidth[i]) &
+			(posY >= contentPosY[i]) &
+			(posY <= contentPosY[i] + contentHeight[i]);
+		if (inSlot | inContent)
+			found.push_back(i);
+	}
 }
 
 
-void event::remove_default_condition_argument(std::string argName)
-{
-	defaultConditionArgs.erase(argName);
-}
+/* CLASS slotBitset */
 
 
-void event::remove_default_effect_argument(std::string argName)
+/*
+- Returns the position of the lowest set bit in a word (which mustn't be 0).
+*/
+static int lowestBit(unsigned long long word)
 {
-	defaultEffectArgs.erase(argName);
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#elif defined(LAYOUT_MSVC_BITS)
+	unsigned long bit;
+	_BitScanForward64(&bit, word);
+	return bit;
+#else
+	int bit = 0;
+	for ( ; !(word & 1) ; word >>= 1)
+		bit ++;
+	return bit;
+#endif
 }
 
 
-void event::activate(std::map<std::string, void*> &conditionArgs,
-	std::map<std::string, void*> &effectArgs)
+/*
+- Returns the position of the highest set bit in a word (which mustn't be 0).
+*/
+static int highestBit(unsigned long long word)
 {
-	std::map<std::string, void*> conArgs =
-		std::map<std::string, void*>(conditionArgs);
-	conArgs.insert(defaultConditionArgs.begin(), defaultConditionArgs.end());
-
-	std::map<std::string, void*> effArgs =
-		std::map<std::string, void*>(effectArgs);
-	effArgs.insert(defaultEffectArgs.begin(), defaultEffectArgs.end());
-
-	if (eventEffect && (!eventCondition || eventCondition(conArgs)))
-		eventEffect(effArgs);
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(word);
+#elif defined(LAYOUT_MSVC_BITS)
+	unsigned long bit;
+	_BitScanReverse64(&bit, word);
+	return bit;
+#else
+	int bit = 0;
+	for ( ; word >>= 1 ; )
+		bit ++;
+	return bit;
+#endif
 }
 
 
-/* CLASS baseFreeLayout */
-
-
-void baseFreeLayout::drawContent()
+/*
+- Returns the number of set bits in a word.
+*/
+static int countBits(unsigned long long word)
 {
-	// First the interval of depths is calculated.
-	int minDepth = std::numeric_limits<int>::max();
-	int maxDepth = std::numeric_limits<int>::min();
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i] && elements[i]->get_visibility())
-		{
-			if (elements[i]->get_depth() < minDepth)
-				minDepth = elements[i]->get_depth();
-			if (elements[i]->get_depth() > maxDepth)
-				maxDepth = elements[i]->get_depth();
-		}
-
-	// Elements are drawn in iterations, from greater to lesser depth.
-	for (int i = maxDepth ; i >= minDepth ; i --)
-		for (int j = 0 ; j < elements.size() ; j ++)
-			if (elements[j] && elements[j]->get_depth() == i &&
-				elements[j]->get_visibility())
-					elements[j]->draw();
+#if defined(__GNUC__)
+	return __builtin_popcountll(word);
+#elif defined(LAYOUT_MSVC_BITS)
+	return (int) __popcnt64(word);
+#else
+	int bits = 0;
+	for ( ; word ; word &= word - 1)
+		bits ++;
+	return bits;
+#endif
 }
 
 
-void baseFreeLayout::recalculateSlotBounds(baseElement &element)
+slotBitset::slotBitset()
 {
+	size = 0;
 }
 
 
-void baseFreeLayout::recalculateAllSlotBounds()
+int slotBitset::get_size() const
 {
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-			recalculateSlotBounds(*elements[i]);
+	return size;
 }
 
 
-baseFreeLayout::baseFreeLayout(int size, ALIGNMENT defaultAlignmentX,
-	ALIGNMENT defaultAlignmentY, bool elastic)
+bool slotBitset::test(int bit) const
 {
-	if (size < 0)
-		size = 0;
-	elements.resize(size);
-	this->defaultAlignmentX = defaultAlignmentX;
-	this->defaultAlignmentY = defaultAlignmentY;
-	this->elastic = elastic;
-	lowestEmptySlot = 0;
-	highestFullSlot = -1;
+	return bit >= 0 && bit < size && (words[bit >> 6] >> (bit & 63)) & 1;
 }
 
 
-baseFreeLayout::~baseFreeLayout()
+int slotBitset::find_next_set(int bit) const
 {
+	if (bit < 0)
+		bit = 0;
+	if (bit >= size)
+		return size;
+	// Bits below the given one are masked out of its word.
+	int i = bit >> 6;
+	unsigned long long word = words[i] & (~0ULL << (bit & 63));
+	while (!word)
+	{
+		if (++ i == words.size())
+			return size;
+		word = words[i];
+	}
+	return (i << 6) + lowestBit(word);
 }
 
 
-int baseFreeLayout::get_size()
+int slotBitset::find_next_cleared(int bit) const
 {
-	return elements.size();
+	if (bit < 0)
+		bit = 0;
+	if (bit >= size)
+		return size;
+	// Bits past the size are cleared, so they may be found (and clamped).
+	int i = bit >> 6;
+	unsigned long long word = ~words[i] & (~0ULL << (bit & 63));
+	while (!word)
+	{
+		if (++ i == words.size())
+			return size;
+		word = ~words[i];
+	}
+	return std::min(size, (i << 6) + lowestBit(word));
 }
 
 
-int baseFreeLayout::get_element_count()
+int slotBitset::find_previous_set(int bit) const
 {
-	return elementCount;
+	if (bit >= size)
+		bit = size - 1;
+	if (bit < 0)
+		return -1;
+	// Bits above the given one are masked out of its word.
+	int i = bit >> 6;
+	unsigned long long word = words[i] & (~0ULL >> (63 - (bit & 63)));
+	while (!word)
+	{
+		if (-- i < 0)
+			return -1;
+		word = words[i];
+	}
+	return (i << 6) + highestBit(word);
 }
 
 
-int baseFreeLayout::get_lowest_empty_slot()
+int slotBitset::find_last_set() const
 {
-	return lowestEmptySlot;
+	return find_previous_set(size - 1);
 }
 
 
-int baseFreeLayout::get_highest_full_slot()
+int slotBitset::count(int first, int last) const
 {
-	return highestFullSlot;
+	first = std::max(first, 0);
+	last = std::min(last, size);
+	if (first >= last)
+		return 0;
+	// The first and last words are masked to the bits in the range.
+	int firstWord = first >> 6, lastWord = (last - 1) >> 6;
+	unsigned long long firstMask = ~0ULL << (first & 63);
+	unsigned long long lastMask = ~0ULL >> (63 - ((last - 1) & 63));
+	if (firstWord == lastWord)
+		return countBits(words[firstWord] & firstMask & lastMask);
+	int bits = countBits(words[firstWord] & firstMask) +
+		countBits(words[lastWord] & lastMask);
+	for (int i = firstWord + 1 ; i < lastWord ; i ++)
+		bits += countBits(words[i]);
+	return bits;
 }
 
 
-ALIGNMENT baseFreeLayout::get_default_alignment_x()
+void slotBitset::resize(int size)
 {
-	return defaultAlignmentX;
+	if (size < 0)
+		size = 0;
+	words.resize((size + 63) >> 6, 0);
+	// Bits past a smaller size are cleared.
+	if (size < this->size && (size & 63))
+		words.back() &= ~0ULL >> (64 - (size & 63));
+	this->size = size;
 }
 
 
-ALIGNMENT baseFreeLayout::get_default_alignment_y()
+void slotBitset::set(int bit)
 {
-	return defaultAlignmentY;
+	if (bit >= 0 && bit < size)
+		words[bit >> 6] |= 1ULL << (bit & 63);
 }
 
 
-bool baseFreeLayout::get_elasticity()
+void slotBitset::reset(int bit)
 {
-	return elastic;
+	if (bit >= 0 && bit < size)
+		words[bit >> 6] &= ~(1ULL << (bit & 63));
 }
 
 
-bool baseFreeLayout::is_slot_full(int slotNumber)
-{
-	bool b = false;
-	if (slotNumber >= 0 && slotNumber < elements.size())
-		b = (elements[slotNumber] != 0);
-	return b;
-}
+/* CLASS elementRange */
 
 
-baseElement* baseFreeLayout::get_element(int slotNumber)
+void elementRange::iterator::skipEmpty()
 {
-	baseElement* e = 0;
-	if (slotNumber >= 0 && slotNumber < elements.size())
-		e = elements[slotNumber];
-	return e;
+	// With a set of full slots, a run of empty ones is skipped at once.
+	if (fullSlots && position != last && !*position)
+		position = first + std::min<std::ptrdiff_t>(last - first,
+			fullSlots->find_next_set(position - first));
+	while (position != last && !*position)
+		position ++;
 }
 
 
-std::vector<baseElement*> baseFreeLayout::get_elements()
+elementRange::iterator::iterator(baseElement *const *position,
+	baseElement *const *last)
 {
-	return elements;
+	this->position = position;
+	this->last = last;
+	first = position;
+	fullSlots = 0;
+	skipEmpty();
 }
 
 
-void baseFreeLayout::set_content_position(float contentPosX, float contentPosY)
+elementRange::iterator::iterator(baseElement *const *position,
+	baseElement *const *last, baseElement *const *first,
+	const slotBitset *fullSlots)
 {
-	baseElement::set_content_position(contentPosX, contentPosY);
-	recalculateAllSlotBounds();
+	this->position = position;
+	this->last = last;
+	this->first = first;
+	this->fullSlots = fullSlots;
+	skipEmpty();
 }
 
 
-void baseFreeLayout::set_content_size(float contentWidth, float contentHeight)
+baseElement& elementRange::iterator::operator*()
 {
-	baseElement::set_content_size(contentWidth, contentHeight);
-	recalculateAllSlotBounds();
+	return **position;
 }
 
 
-void baseFreeLayout::r_match_content_to_slot()
+baseElement* elementRange::iterator::operator->()
 {
-	match_content_to_slot();
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-			elements[i]->r_match_content_to_slot();
+	return *position;
 }
 
 
-void baseFreeLayout::r_match_slot_to_content()
+elementRange::iterator& elementRange::iterator::operator++()
 {
-	match_slot_to_content();
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-			elements[i]->r_match_slot_to_content();
+	position ++;
+	skipEmpty();
+	return *this;
 }
 
 
-void baseFreeLayout::set_default_alignment_x(ALIGNMENT defaultAlignmentX)
+elementRange::iterator elementRange::iterator::operator++(int)
 {
-	if (defaultAlignmentX == none || defaultAlignmentX == left ||
-		defaultAlignmentX == right || defaultAlignmentX == center ||
-		defaultAlignmentX == keep)
-		this->defaultAlignmentX = defaultAlignmentX;
+	iterator previous = *this;
+	++ *this;
+	return previous;
 }
 
 
-void baseFreeLayout::set_default_alignment_y(ALIGNMENT defaultAlignmentY)
+bool elementRange::iterator::operator==(const iterator &other) const
 {
-	if (defaultAlignmentY == none || defaultAlignmentY == top ||
-		defaultAlignmentY == bottom || defaultAlignmentY == center ||
-		defaultAlignmentY == keep)
-		this->defaultAlignmentY = defaultAlignmentY;
+	return position == other.position;
 }
 
 
-void baseFreeLayout::set_default_alignment(ALIGNMENT defaultAlignmentX,
-	ALIGNMENT defaultAlignmentY)
+bool elementRange::iterator::operator!=(const iterator &other) const
 {
-	if (defaultAlignmentX == none || defaultAlignmentX == left ||
-		defaultAlignmentX == right || defaultAlignmentX == center ||
-		defaultAlignmentX == keep)
-		this->defaultAlignmentX = defaultAlignmentX;
-	if (defaultAlignmentY == none || defaultAlignmentY == top ||
-		defaultAlignmentY == bottom || defaultAlignmentY == center ||
-		defaultAlignmentY == keep)
-		this->defaultAlignmentY = defaultAlignmentY;
+	return position != other.position;
 }
 
 
-void baseFreeLayout::r_align()
+elementRange::elementRange()
 {
-	align();
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-			elements[i]->r_align();
+	first = last = 0;
+	fullSlots = 0;
 }
 
 
-void baseFreeLayout::r_align(ALIGNMENT alignmentX, ALIGNMENT alignmentY)
+elementRange::elementRange(const std::vector<baseElement*> &elements)
 {
-	align(alignmentX, alignmentY);
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-			elements[i]->r_align(alignmentX, alignmentY);
+	first = elements.empty() ? 0 : &elements[0];
+	last = first + elements.size();
+	fullSlots = 0;
 }
 
 
-void baseFreeLayout::copy(baseFreeLayout &layout)
+elementRange::elementRange(const std::vector<baseElement*> &elements,
+	const slotBitset &fullSlots)
 {
-	baseElement::copy(layout);
-	layout.defaultAlignmentX = defaultAlignmentX;
-	layout.defaultAlignmentY = defaultAlignmentY;
-	layout.elastic = elastic;
-	layout.recalculateAllSlotBounds();
+	first = elements.empty() ? 0 : &elements[0];
+	last = first + elements.size();
+	this->fullSlots = &fullSlots;
 }
 
 
-void baseFreeLayout::r_copy(baseFreeLayout &layout)
+elementRange::iterator elementRange::begin() const
 {
-	baseFreeLayout::copy(layout);
-	layout.elements.resize(elements.size(), 0);
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-		{
-			layout.elements[i] = elements[i]->r_clone();
-			layout.elements[i]->parentLayout = &layout;
-			layout.elements[i]->slotNumber = i;
-		}
-	layout.elementCount = elementCount;
-	layout.highestFullSlot = highestFullSlot;
-	layout.lowestEmptySlot = lowestEmptySlot;
+	return iterator(first, last, first, fullSlots);
 }
 
 
-void baseFreeLayout::set_size(int size)
+elementRange::iterator elementRange::end() const
 {
-	if (size >= 0)
-	{
-		elements.resize(size, 0);
-		recalculateAllSlotBounds();
-		if (highestFullSlot >= size)
-			for (highestFullSlot = size - 1 ; highestFullSlot >= 0 &&
-				!elements[highestFullSlot] ; highestFullSlot --);
-	}
+	return iterator(last, last, first, fullSlots);
 }
 
 
-void baseFreeLayout::set_elasticity(bool elastic)
+bool elementRange::empty() const
 {
-	this->elastic = elastic;
+	return begin() == end();
 }
 
 
-baseElement* baseFreeLayout::find_element(int elementId)
+int elementRange::size() const
 {
-	baseElement *e = 0;
-	for (int i = 0 ; i < elements.size() && !e ; i ++)
-		if (elements[i])
-			if (elements[i]->get_id() == elementId)
-				e = elements[i];
-			else if (baseFreeLayout *layout = dynamic_cast<baseFreeLayout*>(
-				elements[i]))
-				e = layout->find_element(elementId);
-	return e;
+	if (fullSlots)
+		return fullSlots->count(0, last - first);
+	int count = 0;
+	for (baseElement *const *position = first ; position != last ; position ++)
+		if (*position)
+			count ++;
+	return count;
 }
 
 
-baseElement* baseFreeLayout::find_element(std::string elementName)
+/* CLASS elementHandler */
+
+
+baseElement* elementHandler::findByName(const char *elementName,
+	std::size_t length)
 {
 	baseElement *e = 0;
-	for (int i = 0 ; i < elements.size() && !e ; i ++)
-		if (elements[i])
-			if (elements[i]->get_name() == elementName)
+	if (length == 0)
+	{
+		// Elements without a name aren't indexed, so they're searched for.
+		for (int i = 0 ; i < elements.size() ; i ++)
+			if (elements[i]->name.empty() && (!e || elements[i]->id < e->id))
 				e = elements[i];
-			else if (baseFreeLayout *layout = dynamic_cast<baseFreeLayout*>(
-				elements[i]))
-				e = layout->find_element(elementName);
+		return e;
+	}
+
+	const nameIndex::entryList &found =
+		names.find(nameIndex::hash(elementName, length));
+	for (int i = 0 ; i < found.size() ; i ++)
+		if (nameIndex::has_name(*found[i], elementName, length) &&
+			(!e || found[i]->id < e->id))
+			e = found[i];
 	return e;
 }
 
 
-void baseFreeLayout::add_element(baseElement &element)
+bool elementHandler::hasLowerId(const subscriber &s, long long elementId)
 {
-	add_element(element, lowestEmptySlot);
+	return s.element->id < elementId;
 }
 
 
-void baseFreeLayout::add_element(baseElement &element, int slotNumber)
+void elementHandler::subscribe(baseElement &element,
+	const std::string &eventName, event &e)
 {
-	if (slotNumber >= 0 && !element.parentLayout &&
-		(elastic || slotNumber < elements.size()))
+	subscriberChanges ++;
+	std::vector<subscriber> &list = subscribers[eventName];
+	std::vector<subscriber>::iterator it = std::lower_bound(list.begin(),
+		list.end(), element.id, hasLowerId);
+	if (it != list.end() && it->element == &element)
+		it->subscribedEvent = &e;
+	else
 	{
-		// The size of an elastic layout is expanded if necessary.
-		if (slotNumber >= elements.size())
-		{
-			elements.resize(slotNumber + 1, 0);
-			recalculateAllSlotBounds();
-		}
-
-		// The new element's slot and alignment are recalculated.
-		// 'keep' will leave the alignment in an axis unchanged.
-		recalculateSlotBounds(element);
-		element.set_alignment(defaultAlignmentX, defaultAlignmentY);
-		if (baseFreeLayout *layout = dynamic_cast<baseFreeLayout*>(&element))
-			layout->set_default_alignment(defaultAlignmentX, defaultAlignmentY);
-
-		// The element is added to the slot.
-		if (!elements[slotNumber])
-			elementCount ++;
-		elements[slotNumber] = &element;
-		element.parentLayout = this;
-		element.slotNumber = slotNumber;
-
-		// The lowest empty slot and the highest full slot are recalculated.
-		while (lowestEmptySlot < elements.size() && elements[lowestEmptySlot])
-			lowestEmptySlot ++;
-		if (slotNumber > highestFullSlot)
-			highestFullSlot = slotNumber;
+		subscriber s;
+		s.element = &element;
+		s.subscribedEvent = &e;
+		list.insert(it, s);
 	}
 }
 
 
-baseElement* baseFreeLayout::remove_element(int slotNumber)
+void elementHandler::unsubscribe(baseElement &element,
+	const std::string &eventName)
 {
-	baseElement *e = 0;
-	if (slotNumber >=0 && slotNumber < elements.size() && elements[slotNumber])
+	subscriberChanges ++;
+	std::map<std::string, std::vector<subscriber> >::iterator entry =
+		subscribers.find(eventName);
+	if (entry != subscribers.end())
 	{
-		e = elements[slotNumber];
-		e->parentLayout = 0;
-		e->slotNumber = -1;
-		elements[slotNumber] = 0;
-		elementCount --;
-		if (slotNumber < lowestEmptySlot)
-			lowestEmptySlot = slotNumber;
-		while (highestFullSlot >= 0 && !elements[highestFullSlot])
-			highestFullSlot --;
+		std::vector<subscriber> &list = entry->second;
+		std::vector<subscriber>::iterator it = std::lower_bound(list.begin(),
+			list.end(), element.id, hasLowerId);
+		if (it != list.end() && it->element == &element)
+			list.erase(it);
+		if (list.empty())
+			subscribers.erase(entry);
 	}
-	return e;
 }
 
 
-void baseFreeLayout::remove_element(baseElement &element)
+elementHandler::subscriber* elementHandler::nextSubscriber(
+	const std::string &eventName, long long elementId)
 {
-	// We check thet the element is indeed in the layout.
-	bool inLayout = false;
-	for (baseFreeLayout *l = element.parentLayout ; l && !inLayout ;
-		l = l->parentLayout)
-		if (l == this)
-			inLayout = true;
-	// We remove the element.
-	if (inLayout)
-		element.parentLayout->remove_element(element.slotNumber);
+	std::map<std::string, std::vector<subscriber> >::iterator entry =
+		subscribers.find(eventName);
+	if (entry == subscribers.end())
+		return 0;
+	std::vector<subscriber> &list = entry->second;
+	std::vector<subscriber>::iterator it = std::lower_bound(list.begin(),
+		list.end(), elementId + 1, hasLowerId);
+	return it != list.end() ? &*it : 0;
 }
 
 
-void baseFreeLayout::r_delete()
+long long elementHandler::cellKey(int cellX, int cellY)
 {
-	for (int i = 0 ; i < elements.size() ; i ++)
-		if (elements[i])
-			elements[i]->r_delete();
-	delete this;
+	return ((long long) cellX << 32) | (unsigned int) cellY;
 }
 
 
-/* CLASS baseHorizontalLayout */
+int elementHandler::cellCoordinate(float pos)
+{
+	float cell = std::floor(pos / cellSize);
+	// Coordinates out of range (or not a number) are clamped, so that they
+	// can be converted. Their elements are considered big.
+	if (!(cell > -1e9f))
+		return -1000000000;
+	if (cell > 1e9f)
+		return 1000000000;
+	return (int) cell;
+}
 
 
-void baseHorizontalLayout::recalculateSlotBounds(baseElement &element)
+elementHandler::cellRange elementHandler::getCellRange(float posX,
+	float posY, float width, float height)
 {
-	if (elements.size() > 0)
+	// Frames may have negative sizes, so both corners are compared.
+	cellRange range;
+	range.minX = cellCoordinate(std::min(posX, posX + width));
+	range.minY = cellCoordinate(std::min(posY, posY + height));
+	range.maxX = cellCoordinate(std::max(posX, posX + width));
+	range.maxY = cellCoordinate(std::max(posY, posY + height));
+	return range;
+}
+
+
+elementHandler::elementCells elementHandler::getElementCells(
+	baseElement &element)
+{
+	elementCells where;
+	where.slotCells = getCellRange(element.slotPosX, element.slotPosY,
+		element.slotWidth, element.slotHeight);
+	where.contentCells = getCellRange(element.contentPosX,
+		element.contentPosY, element.contentWidth, element.contentHeight);
+	where.big = false;
+	for (int i = 0 ; i < 2 ; i ++)
 	{
-		int slotNumber = element.get_slot_number();
-		float slotsWidth = contentWidth / elements.size();
-		element.set_slot_position(contentPosX + slotNumber * slotsWidth,
-			contentPosY);
-		element.set_slot_size(slotsWidth, contentHeight);
+		cellRange &range = i ? where.contentCells : where.slotCells;
+		if ((long long) (range.maxX - range.minX + 1) *
+			(range.maxY - range.minY + 1) > maxFrameCells)
+			where.big = true;
 	}
+	return where;
 }
 
 
-baseHorizontalLayout::baseHorizontalLayout()
+bool elementHandler::isInRange(const cellRange &range, int cellX, int cellY)
 {
+	return cellX >= range.minX && cellX <= range.maxX &&
+		cellY >= range.minY && cellY <= range.maxY;
 }
 
 
-baseHorizontalLayout::~baseHorizontalLayout()
+bool elementHandler::isSameRange(const cellRange &range1,
+	const cellRange &range2)
 {
+	return range1.minX == range2.minX && range1.minY == range2.minY &&
+		range1.maxX == range2.maxX && range1.maxY == range2.maxY;
 }
 
 
-/* CLASS verticalLayout */
+void elementHandler::addToCells(baseElement &element,
+	const elementCells &where)
+{
+	if (where.big)
+		bigElements.push_back(&element);
+	else
+		for (int i = 0 ; i < 2 ; i ++)
+		{
+			const cellRange &range = i ? where.contentCells : where.slotCells;
+			for (int x = range.minX ; x <= range.maxX ; x ++)
+				for (int y = range.minY ; y <= range.maxY ; y ++)
+					// Cells overlapped by both frames only store it once.
+					if (!i || !isInRange(where.slotCells, x, y))
+						cells[cellKey(x, y)].push_back(&element);
+		}
+}
 
 
-void baseVerticalLayout::recalculateSlotBounds(baseElement &element)
+void elementHandler::removeFromCells(baseElement &element,
+	const elementCells &where)
 {
-	if (elements.size() > 0)
+	if (where.big)
+		bigElements.erase(std::find(bigElements.begin(), bigElements.end(),
+			&element));
+	else
+		for (int i = 0 ; i < 2 ; i ++)
+		{
+			const cellRange &range = i ? where.contentCells : where.slotCells;
+			for (int x = range.minX ; x <= range.maxX ; x ++)
+				for (int y = range.minY ; y <= range.maxY ; y ++)
+					if (!i || !isInRange(where.slotCells, x, y))
+					{
+						std::unordered_map<long long,
+							std::vector<baseElement*> >::iterator cell =
+							cells.find(cellKey(x, y));
+						std::vector<baseElement*> &list = cell->second;
+						list.erase(std::find(list.begin(), list.end(),
+							&element));
+						if (list.empty())
+							cells.erase(cell);
+					}
+		}
+}
+
+
+void elementHandler::indexGeometry(baseElement &element)
+{
+	elementCells where = getElementCells(element);
+	std::unordered_map<baseElement*, elementCells>::iterator it =
+		indexedCells.find(&element);
+	if (it != indexedCells.end())
 	{
-		int slotNumber = element.get_slot_number();
-		float slotsHeight = contentHeight / elements.size(); 
-		element.set_slot_position(contentPosX, contentPosY + slotNumber *
-			slotsHeight);
-		element.set_slot_size(contentWidth, slotsHeight);
+		elementCells &old = it->second;
+		if (isSameRange(old.slotCells, where.slotCells) &&
+			isSameRange(old.contentCells, where.contentCells))
+			// The element hasn't moved to other cells.
+			return;
+		removeFromCells(element, old);
+		old = where;
 	}
+	else
+		indexedCells[&element] = where;
+	addToCells(element, where);
 }
 
 
-baseVerticalLayout::baseVerticalLayout()
+void elementHandler::unindexGeometry(baseElement &element)
 {
+	std::unordered_map<baseElement*, elementCells>::iterator it =
+		indexedCells.find(&element);
+	if (it != indexedCells.end())
+	{
+		removeFromCells(element, it->second);
+		indexedCells.erase(it);
+	}
 }
 
 
-baseVerticalLayout::~baseVerticalLayout()
+bool elementHandler::hasLowerElementId(baseElement *element1,
+	baseElement *element2)
 {
+	return element1->id < element2->id;
 }
 
 
-/* CLASS tableLayout */
+void elementHandler::countStored(geometryStore *store, int count)
+{
+	if (store && (storedElements[store] += count) == 0)
+		storedElements.erase(store);
+}
+
+
+int elementHandler::handlerIndex(baseElement &element)
+{
+	// Elements are in few handlers, so the list is short.
+	for (int i = 0 ; i < element.handlers.size() ; i ++)
+		if (element.handlers[i] == this)
+			return i;
+	return -1;
+}
+
+
+bool elementHandler::isElementAt(baseElement &element,
+	const positionArguments &position)
+{
+	return position_inside_slot_frame(element, position) ||
+		position_inside_content_frame(element, position);
+}
+
+
+elementHandler::elementHandler()
+{
+	cellSize = 0;
+	subscriberChanges = 0;
+}
+
+
+elementHandler::elementHandler(elementHandler &handler)
+{
+	cellSize = 0;
+	subscriberChanges = 0;
+	handler.copy(*this);
+}
+
+
+elementHandler::~elementHandler()
+{
+	while (!elements.empty())
+		remove_element(*elements.back());
+}
+
+
+std::map<long long, baseElement*> elementHandler::get_map()
+{
+	std::map<long long, baseElement*> idMap;
+	for (int i = 0 ; i < elements.size() ; i ++)
+		idMap[elements[i]->id] = elements[i];
+	return idMap;
+}
+
+
+const std::vector<baseElement*>& elementHandler::get_elements()
+{
+	return elements;
+}
+
+
+elementRange elementHandler::get_element_range()
+{
+	return elementRange(elements);
+}
+
+
+void elementHandler::copy(elementHandler &handler)
+{
+	while (!handler.elements.empty())
+		handler.remove_element(*handler.elements.back());
+	handler.set_spatial_index(cellSize);
+	for (int i = 0 ; i < elements.size() ; i ++)
+		handler.add_element(*elements[i]);
+}
+
+
+baseElement* elementHandler::find_element(long long elementId)
+{
+	baseElement *element = baseElement::findById(elementId);
+	if (element && handlerIndex(*element) >= 0)
+		return element;
+	return 0;
+}
+
+
+baseElement* elementHandler::find_element(const std::string &elementName)
+{
+	return findByName(elementName.data(), elementName.size());
+}
+
+
+baseElement* elementHandler::find_element(const char *elementName)
+{
+	return findByName(elementName, std::char_traits<char>::length(elementName));
+}
+
+
+#ifdef LAYOUT_STRING_VIEW
+baseElement* elementHandler::find_element(std::string_view elementName)
+{
+	return findByName(elementName.data(), elementName.size());
+}
+#endif
+
+
+void elementHandler::add_element(baseElement &element)
+{
+	if (handlerIndex(element) < 0)
+	{
+		element.handlers.push_back(this);
+		element.handlerPositions.push_back(elements.size());
+		elements.push_back(&element);
+		names.add(element);
+		for (std::map<std::string, event*>::iterator it =
+			element.events.begin() ; it != element.events.end() ; it ++)
+			subscribe(element, it->first, *it->second);
+		if (cellSize > 0)
+			indexGeometry(element);
+		countStored(element.geometry, 1);
+	}
+}
+
+
+void elementHandler::r_add_element(baseElement &element)
+{
+	for (layoutIterator it(element) ; !it.is_done() ; it.next())
+		add_element(*it);
+}
+
+
+void elementHandler::remove_element(baseElement &element)
+{
+	int i = handlerIndex(element);
+	if (i >= 0)
+	{
+		// The last element takes the place of the removed one.
+		int position = element.handlerPositions[i];
+		baseElement *last = elements.back();
+		elements[position] = last;
+		last->handlerPositions[handlerIndex(*last)] = position;
+		elements.pop_back();
+		element.handlers.erase(element.handlers.begin() + i);
+		element.handlerPositions.erase(element.handlerPositions.begin() + i);
+		names.remove(element);
+		for (std::map<std::string, event*>::iterator it =
+			element.events.begin() ; it != element.events.end() ; it ++)
+			unsubscribe(element, it->first);
+		unindexGeometry(element);
+		countStored(element.geometry, -1);
+	}
+}
+
+
+void elementHandler::r_remove_element(baseElement &element)
+{
+	for (layoutIterator it(element) ; !it.is_done() ; it.next())
+		remove_element(*it);
+}
+
+
+void elementHandler::activate_events(std::string eventName,
+	std::map<std::string, void*> &conditionArgs,
+	std::map<std::string, void*> &effectArgs)
+{
+	// The list is looked up again after every event, as effects may add or
+	// remove events or elements (erasing the list when it's left empty).
+	long long elementId = -1;
+	while (subscriber *s = nextSubscriber(eventName, elementId))
+	{
+		elementId = s->element->id;
+		s->subscribedEvent->activate(conditionArgs, effectArgs);
+	}
+}
+
+
+float elementHandler::get_spatial_index()
+{
+	return cellSize;
+}
+
+
+void elementHandler::set_spatial_index(float cellSize)
+{
+	cells.clear();
+	indexedCells.clear();
+	bigElements.clear();
+	this->cellSize = cellSize > 0 ? cellSize : 0;
+	if (this->cellSize > 0)
+		for (int i = 0 ; i < elements.size() ; i ++)
+			indexGeometry(*elements[i]);
+}
+
+
+void elementHandler::find_elements_at(float posX, float posY,
+	std::vector<baseElement*> &found)
+{
+	positionArguments position;
+	position.posX = posX;
+	position.posY = posY;
+	found.clear();
+	if (cellSize > 0)
+	{
+		std::unordered_map<long long, std::vector<baseElement*> >::iterator
+			cell = cells.find(cellKey(cellCoordinate(posX),
+			cellCoordinate(posY)));
+		if (cell != cells.end())
+			for (int i = 0 ; i < cell->second.size() ; i ++)
+				if (isElementAt(*cell->second[i], position))
+					found.push_back(cell->second[i]);
+		for (int i = 0 ; i < bigElements.size() ; i ++)
+			if (isElementAt(*bigElements[i], position))
+				found.push_back(bigElements[i]);
+	}
+	else if (storedElements.size() == 1 &&
+		storedElements.begin()->second == elements.size() &&
+		storedElements.begin()->first->get_size() <= 4 * elements.size())
+	{
+		// The store may hold elements of other handlers, which are skipped.
+		geometryStore &store = *storedElements.begin()->first;
+		store.find_elements_at(posX, posY, storedHits);
+		for (int i = 0 ; i < storedHits.size() ; i ++)
+		{
+			baseElement *e = store.get_element(storedHits[i]);
+			if (handlerIndex(*e) >= 0)
+				found.push_back(e);
+		}
+	}
+	else
+		for (int i = 0 ; i < elements.size() ; i ++)
+			if (isElementAt(*elements[i], position))
+				found.push_back(elements[i]);
+	std::sort(found.begin(), found.end(), hasLowerElementId);
+}
+
+
+void elementHandler::findIdsAt(float posX, float posY,
+	std::vector<long long> &ids)
+{
+	find_elements_at(posX, posY, hitElements);
+	ids.resize(hitElements.size());
+	for (int i = 0 ; i < hitElements.size() ; i ++)
+		ids[i] = hitElements[i]->id;
+	hitElements.clear();
+}
+
+
+void elementHandler::activate_events_at(std::string eventName, float posX,
+	float posY, std::map<std::string, void*> &conditionArgs,
+	std::map<std::string, void*> &effectArgs)
+{
+	// The vector is taken from 'hitIds' (and given back) so its memory is
+	// reused, unless effects activate events themselves. Elements are found
+	// again by id, as effects may delete them or remove them from the handler.
+	std::vector<long long> ids;
+	ids.swap(hitIds);
+	findIdsAt(posX, posY, ids);
+	for (int i = 0 ; i < ids.size() ; i ++)
+		if (baseElement *element = find_element(ids[i]))
+			if (event *e = element->find_event(eventName))
+				e->activate(conditionArgs, effectArgs);
+	ids.clear();
+	hitIds.swap(ids);
+}
+
+
+void elementHandler::activate_events_batch(std::string eventName,
+	int positionCount, const float *posX, const float *posY,
+	std::map<std::string, void*> &conditionArgs,
+	std::map<std::string, void*> &effectArgs)
+{
+	std::map<std::string, std::vector<subscriber> >::iterator entry =
+		subscribers.find(eventName);
+	if (entry == subscribers.end())
+		return;
+	std::vector<subscriber> &list = entry->second;
+	const void *positionType =
+		typedEventBase<positionArguments>::arguments_type();
+	event::viewConditionType slotCondition = position_inside_slot_frame;
+	event::viewConditionType contentCondition = position_inside_content_frame;
+
+	// The frames checked by stock conditions are packed, along with the id of
+	// their element and their event, which only identify them later on: the
+	// list may change while effects run, so nothing is kept from it.
+	std::vector<float> left, top, right, bottom;
+	std::vector<long long> framedIds;
+	std::vector<event*> framedEvents;
+	for (int i = 0 ; i < list.size() ; i ++)
+	{
+		event *e = list[i].subscribedEvent;
+		baseElement *elem = 0;
+		if (e->viewCondition == slotCondition ||
+			e->viewCondition == contentCondition)
+			elem = static_cast<baseElement*>(argumentView(conditionArgs,
+				e->defaultConditionArgs).get("element"));
+		if (elem && e->viewCondition == slotCondition)
+		{
+			left.push_back(elem->get_slot_position_x());
+			top.push_back(elem->get_slot_position_y());
+			right.push_back(left.back() + elem->get_slot_width());
+			bottom.push_back(top.back() + elem->get_slot_height());
+		}
+		else if (elem)
+		{
+			left.push_back(elem->get_content_position_x());
+			top.push_back(elem->get_content_position_y());
+			right.push_back(left.back() + elem->get_content_width());
+			bottom.push_back(top.back() + elem->get_content_height());
+		}
+		if (elem)
+		{
+			framedIds.push_back(list[i].element->id);
+			framedEvents.push_back(e);
+		}
+	}
+
+	positionArguments position;
+	std::vector<unsigned char> inside(framedIds.size());
+	for (int p = 0 ; p < positionCount ; p ++)
+	{
+		position.posX = posX[p];
+		position.posY = posY[p];
+		if (!framedIds.empty())
+			testContainment(framedIds.size(), &left[0], &top[0], &right[0],
+				&bottom[0], position.posX, position.posY, &inside[0]);
+
+		// As in 'activate_events', the list is looked up again (after the
+		// last element visited) whenever effects have changed it. Both lists
+		// are sorted by id, so packed frames are found in turn. Events added
+		// in the meantime have their condition checked.
+		long long elementId = -1;
+		int f = 0, next = 0, changes = subscriberChanges - 1;
+		std::vector<subscriber> *current = 0;
+		while (true)
+		{
+			if (changes != subscriberChanges)
+			{
+				changes = subscriberChanges;
+				entry = subscribers.find(eventName);
+				if (entry == subscribers.end())
+					break;
+				current = &entry->second;
+				next = std::lower_bound(current->begin(), current->end(),
+					elementId + 1, hasLowerId) - current->begin();
+			}
+			if (next == current->size())
+				break;
+			subscriber *s = &(*current)[next ++];
+			elementId = s->element->id;
+			event *e = s->subscribedEvent;
+			while (f < framedIds.size() && framedIds[f] < elementId)
+				f ++;
+			if (f < framedIds.size() && framedIds[f] == elementId &&
+				framedEvents[f] == e)
+			{
+				if (inside[f])
+					e->activateEffect(effectArgs);
+			}
+			else if (e->argumentsType == positionType)
+				static_cast<typedEventBase<positionArguments>*>(e)->activate(
+					*s->element, position);
+			else
+				// The position is added to the arguments without copying them.
+				e->activateView(argumentView(position.posX, position.posY,
+					conditionArgs, e->defaultConditionArgs), effectArgs);
+		}
+	}
+}
+
+
+void elementHandler::activate_events_at(const std::string &eventName,
+	const positionArguments &args)
+{
+	const void *argumentsType =
+		typedEventBase<positionArguments>::arguments_type();
+	// As in the other overload, elements are found again by id.
+	std::vector<long long> ids;
+	ids.swap(hitIds);
+	findIdsAt(args.posX, args.posY, ids);
+	for (int i = 0 ; i < ids.size() ; i ++)
+	{
+		baseElement *element = find_element(ids[i]);
+		event *e = element ? element->find_event(eventName) : 0;
+		if (e && e->argumentsType == argumentsType)
+			static_cast<typedEventBase<positionArguments>*>(e)->activate(
+				*element, args);
+	}
+	ids.clear();
+	hitIds.swap(ids);
+}
+
+
+/* CLASS argumentView */
+
+
+bool argumentView::lookup(const std::string &argName, void *&argValue) const
+{
+	if (posX && argName.size() == 4 && argName.compare(0, 3, "pos") == 0 &&
+		(argName[3] == 'X' || argName[3] == 'Y'))
+	{
+		argValue = argName[3] == 'X' ? posX : posY;
+		return true;
+	}
+	std::map<std::string, void*>::iterator it = args->find(argName);
+	if (it == args->end() && defaultArgs)
+	{
+		it = defaultArgs->find(argName);
+		if (it == defaultArgs->end())
+			return false;
+	}
+	else if (it == args->end())
+		return false;
+	argValue = it->second;
+	return true;
+}
+
+
+argumentView::argumentView(std::map<std::string, void*> &args)
+{
+	this->args = &args;
+	defaultArgs = 0;
+	posX = posY = 0;
+}
+
+
+argumentView::argumentView(std::map<std::string, void*> &args,
+	std::map<std::string, void*> &defaultArgs)
+{
+	this->args = &args;
+	this->defaultArgs = &defaultArgs;
+	posX = posY = 0;
+}
+
+
+argumentView::argumentView(float &posX, float &posY,
+	std::map<std::string, void*> &args,
+	std::map<std::string, void*> &defaultArgs)
+{
+	this->args = &args;
+	this->defaultArgs = &defaultArgs;
+	this->posX = &posX;
+	this->posY = &posY;
+}
+
+
+bool argumentView::has(const std::string &argName) const
+{
+	void *argValue;
+	return lookup(argName, argValue);
+}
+
+
+void* argumentView::get(const std::string &argName) const
+{
+	void *argValue = 0;
+	lookup(argName, argValue);
+	return argValue;
+}
+
+
+void argumentView::to_map(std::map<std::string, void*> &argMap) const
+{
+	argMap = *args;
+	if (posX)
+	{
+		argMap["posX"] = posX;
+		argMap["posY"] = posY;
+	}
+	// Given arguments are already in the map, so defaults don't replace them.
+	if (defaultArgs)
+		argMap.insert(defaultArgs->begin(), defaultArgs->end());
+}
+
+
+/* CLASS event */
+
+
+event::event(eventConditionType eventCondition, eventEffectType eventEffect,
+	std::map<std::string, void*> &defaultConditionArgs,
+	std::map<std::string, void*> &defaultEffectArgs)
+{
+	this->eventCondition = eventCondition;
+	viewCondition = 0;
+	this->eventEffect = eventEffect;
+	viewEffect = 0;
+	propagates = true;
+	argumentsType = 0;
+	this->defaultConditionArgs =
+		std::map<std::string, void*>::map<std::string, void*>(
+		defaultConditionArgs);
+	this->defaultEffectArgs =
+		std::map<std::string, void*>::map<std::string, void*>(
+		defaultEffectArgs);
+}
+
+
+event::~event()
+{
+}
+
+
+event::eventConditionType event::get_event_condition()
+{
+	return eventCondition;
+}
+
+
+event::viewConditionType event::get_event_view_condition()
+{
+	return viewCondition;
+}
+
+
+event::eventEffectType event::get_event_effect()
+{
+	return eventEffect;
+}
+
+
+event::viewEffectType event::get_event_view_effect()
+{
+	return viewEffect;
+}
+
+
+std::map<std::string, void*>& event::get_default_condition_args()
+{
+	return defaultConditionArgs;
+}
+
+
+std::map<std::string, void*>& event::get_default_effect_args()
+{
+	return defaultEffectArgs;
+}
+
+
+bool event::get_propagation()
+{
+	return propagates;
+}
+
+
+void event::set_event_condition(eventConditionType eventCondition)
+{
+	this->eventCondition = eventCondition;
+	viewCondition = 0;
+}
+
+
+void event::set_event_condition(viewConditionType viewCondition)
+{
+	this->viewCondition = viewCondition;
+	eventCondition = 0;
+}
+
+
+void event::set_event_effect(eventEffectType eventEffect)
+{
+	this->eventEffect = eventEffect;
+	viewEffect = 0;
+}
+
+
+void event::set_event_effect(viewEffectType viewEffect)
+{
+	this->viewEffect = viewEffect;
+	eventEffect = 0;
+}
+
+
+void event::set_default_condition_args(
+	std::map<std::string, void*> &defaultConditionArgs)
+{
+	this->defaultConditionArgs =
+		std::map<std::string, void*>::map<std::string, void*>(
+		defaultConditionArgs);
+}
+
+
+void event::set_default_effect_args(
+	std::map<std::string, void*> &defaultConditionArgs)
+{
+	this->defaultEffectArgs =
+		std::map<std::string, void*>::map<std::string, void*>(
+		defaultEffectArgs);
+}
+
+
+void event::set_propagation(bool propagates)
+{
+	this->propagates = propagates;
+}
+
+
+void event::add_default_condition_argument(std::string argName, void *argValue)
+{
+	defaultConditionArgs[argName] = argValue;
+}
+
+
+void event::add_default_effect_argument(std::string argName, void *argValue)
+{
+	defaultEffectArgs[argName] = argValue;
+}
+
+
+void event::remove_default_condition_argument(std::string argName)
+{
+	defaultConditionArgs.erase(argName);
+}
+
+
+void event::remove_default_effect_argument(std::string argName)
+{
+	defaultEffectArgs.erase(argName);
+}
+
+
+void event::activateEffect(std::map<std::string, void*> &effectArgs)
+{
+	argumentView effArgs(effectArgs, defaultEffectArgs);
+	if (viewEffect)
+		viewEffect(effArgs);
+	else if (eventEffect)
+	{
+		// The effect expects a map, so one has to be built.
+		std::map<std::string, void*> effArgMap;
+		effArgs.to_map(effArgMap);
+		eventEffect(effArgMap);
+	}
+}
+
+
+bool event::activate(std::map<std::string, void*> &conditionArgs,
+	std::map<std::string, void*> &effectArgs)
+{
+	return activateView(argumentView(conditionArgs, defaultConditionArgs),
+		effectArgs);
+}
+
+
+bool event::activateView(const argumentView &conArgs,
+	std::map<std::string, void*> &effectArgs)
+{
+	if (!eventEffect && !viewEffect)
+		return false;
+
+	bool fulfilled = true;
+	if (viewCondition)
+		fulfilled = viewCondition(conArgs);
+	else if (eventCondition)
+	{
+		// The condition expects a map, so one has to be built.
+		std::map<std::string, void*> conArgMap;
+		conArgs.to_map(conArgMap);
+		fulfilled = eventCondition(conArgMap);
+	}
+
+	if (fulfilled)
+		activateEffect(effectArgs);
+	return fulfilled;
+}
+
+
+/* CLASS baseFreeLayout */
+
+
+void baseFreeLayout::drawContent()
+{
+	// Elements inside are drawn the same way as in 'draw', but the content of
+	// the layouts among them is drawn by the traversal itself.
+	layoutIterator it(*this, depthorder);
+	for (it.next() ; !it.is_done() ; it.next())
+	{
+		baseElement &element = *it;
+		if (element.layoutDirty)
+			element.update_layout();
+		if (!element.drawFrame() || !element.contentVisible)
+			it.skip_children();
+		else if (!element.is_layout())
+			element.drawContent();
+	}
+}
+
+
+bool baseFreeLayout::hasGreaterDepth(baseElement *element1,
+	baseElement *element2)
+{
+	return element1->depth > element2->depth;
+}
+
+
+void baseFreeLayout::sortDrawOrder()
+{
+	drawOrder.clear();
+	elementRange range(elements, fullSlots);
+	for (elementRange::iterator it = range.begin() ; it != range.end() ; it ++)
+		if (it->visible)
+			drawOrder.push_back(&*it);
+	// The sort is stable, so elements with the same depth keep slot order.
+	std::stable_sort(drawOrder.begin(), drawOrder.end(), hasGreaterDepth);
+	drawOrderDirty = false;
+}
+
+
+baseFreeLayout* baseFreeLayout::indexingLayout()
+{
+	baseFreeLayout *layout = this;
+	while (layout->parentLayout)
+		layout = layout->parentLayout;
+	return layout;
+}
+
+
+void baseFreeLayout::indexElement(baseElement &element)
+{
+	// A layout being added was outermost, so its index moves up.
+	nameIndex &index = indexingLayout()->names;
+	index.add(element);
+	if (baseFreeLayout *layout = element.as_layout())
+	{
+		index.add(layout->names);
+		layout->names.clear();
+	}
+}
+
+
+void baseFreeLayout::unindexElement(baseElement &element)
+{
+	// A layout being removed becomes outermost, so it takes its elements.
+	nameIndex &index = indexingLayout()->names;
+	index.remove(element);
+	if (baseFreeLayout *layout = element.as_layout())
+	{
+		layoutIterator it(*layout);
+		for (it.next() ; !it.is_done() ; it.next())
+		{
+			index.remove(*it);
+			layout->names.add(*it);
+		}
+	}
+}
+
+
+void baseFreeLayout::resizeElements(int size)
+{
+	if (sparse)
+	{
+		// Elements are removed from the last one, so none are moved.
+		while (!elements.empty() && elements.back()->slotNumber >= size)
+			baseFreeLayout::remove_element(elements.back()->slotNumber);
+		sparseSize = size;
+	}
+	else
+	{
+		for (int i = fullSlots.find_next_set(size) ; i < elements.size() ;
+			i = fullSlots.find_next_set(i + 1))
+			baseFreeLayout::remove_element(i);
+		elements.resize(size, 0);
+		fullSlots.resize(size);
+	}
+	if (lowestEmptySlot > size)
+		lowestEmptySlot = size;
+	markSlotsDirty();
+	markDrawOrderDirty();
+}
+
+
+void baseFreeLayout::growElements(int size)
+{
+	if (size > get_size())
+	{
+		if (sparse)
+			sparseSize = size;
+		else
+		{
+			if (size > elements.capacity())
+				elements.reserve(std::max<size_t>(size,
+					2 * elements.capacity()));
+			elements.resize(size, 0);
+			fullSlots.resize(size);
+		}
+		markSlotsDirty();
+	}
+}
+
+
+void baseFreeLayout::placeElement(baseElement &element, int slotNumber)
+{
+	// The element is added to the slot, replacing the old one (if any).
+	if (baseFreeLayout::get_element(slotNumber))
+		baseFreeLayout::remove_element(slotNumber);
+	elementCount ++;
+	if (sparse)
+	{
+		// The elements after it are moved, and every position stays full.
+		elements.insert(elements.begin() + findPosition(slotNumber), &element);
+		fullSlots.resize(elements.size());
+		fullSlots.set(elements.size() - 1);
+	}
+	else
+	{
+		elements[slotNumber] = &element;
+		fullSlots.set(slotNumber);
+	}
+	element.parentLayout = this;
+	element.slotNumber = slotNumber;
+	indexElement(element);
+	markDrawOrderDirty();
+	markBoundsDirty();
+	if (element.layoutDirty)
+		markLayoutDirty();
+
+	// The element joins the layout's geometry store, unless it's already
+	// in one.
+	if (geometry && !element.geometry)
+		element.r_set_geometry_store(*geometry);
+
+	// 'keep' will leave the alignment in an axis unchanged. The element has
+	// no slot yet, so pending slots needn't be applied first.
+	element.assignAlignment(defaultAlignmentX, defaultAlignmentY);
+	if (baseFreeLayout *layout = element.as_layout())
+		layout->set_default_alignment(defaultAlignmentX, defaultAlignmentY);
+}
+
+
+void baseFreeLayout::placeElements(const std::vector<baseElement*> &newElements,
+	int slotNumber)
+{
+	// Memory for all the elements is reserved at once, and so is growing the
+	// layout (which changes every slot in elastic layouts) for each element.
+	bool lowest = slotNumber < 0;
+	int first = lowest ? lowestEmptySlot : slotNumber;
+	if (sparse)
+		reserve(elements.size() + newElements.size());
+	else if (elastic)
+		reserve(first + newElements.size());
+	std::vector<baseElement*> placed;
+	placed.reserve(newElements.size());
+	for (int i = 0 ; i < newElements.size() ; i ++)
+	{
+		baseElement *e = newElements[i];
+		if (!e || e->parentLayout)
+			continue;
+		int slot = lowest ? lowestEmptySlot : slotNumber ++;
+		if (slot >= get_size())
+		{
+			if (!elastic)
+				break;
+			growElements(slot + 1);
+		}
+		placeElement(*e, slot);
+		placed.push_back(e);
+		if (slot == lowestEmptySlot)
+			lowestEmptySlot = get_next_empty_slot(slot);
+		if (slot > highestFullSlot)
+			highestFullSlot = slot;
+	}
+
+	// Slots are recalculated once: all together if any must be (e.g. because
+	// the layout grew), or else just the new elements'.
+	if (placed.empty())
+		return;
+	if (is_updating())
+		markSlotsDirty();
+	else if (slotsDirty)
+	{
+		slotsDirty = false;
+		recalculateAllSlotBounds();
+	}
+	else
+		for (int i = 0 ; i < placed.size() ; i ++)
+			recalculateSlotBounds(*placed[i]);
+	checkDensity();
+}
+
+
+int baseFreeLayout::findPosition(int slotNumber)
+{
+	int first = 0, last = elements.size();
+	while (first < last)
+	{
+		int middle = (first + last) / 2;
+		if (elements[middle]->slotNumber < slotNumber)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+	return first;
+}
+
+
+void baseFreeLayout::convertStorage(bool sparse)
+{
+	if (sparse == this->sparse)
+		return;
+	// New vectors are built and swapped in, so the memory of the old ones is
+	// freed.
+	std::vector<baseElement*> newElements;
+	slotBitset newFullSlots;
+	if (sparse)
+	{
+		newElements.reserve(elementCount);
+		for (int i = fullSlots.find_next_set(0) ; i < elements.size() ;
+			i = fullSlots.find_next_set(i + 1))
+			newElements.push_back(elements[i]);
+		newFullSlots.resize(elementCount);
+		for (int i = 0 ; i < elementCount ; i ++)
+			newFullSlots.set(i);
+		sparseSize = elements.size();
+	}
+	else
+	{
+		newElements.resize(sparseSize, 0);
+		newFullSlots.resize(sparseSize);
+		for (int i = 0 ; i < elements.size() ; i ++)
+		{
+			newElements[elements[i]->slotNumber] = elements[i];
+			newFullSlots.set(elements[i]->slotNumber);
+		}
+		sparseSize = 0;
+	}
+	elements.swap(newElements);
+	std::swap(fullSlots, newFullSlots);
+	this->sparse = sparse;
+}
+
+
+void baseFreeLayout::checkDensity()
+{
+	// Small layouts always use dense storage.
+	const int minimumSize = 64;
+	if (sparseDensity <= 0 || !supportsSparseSlots())
+		return;
+	int size = get_size();
+	if (!sparse && size >= minimumSize && elementCount < sparseDensity * size)
+		convertStorage(true);
+	else if (sparse && (size < minimumSize ||
+		elementCount >= 2 * sparseDensity * size))
+		convertStorage(false);
+}
+
+
+bool baseFreeLayout::supportsSparseSlots()
+{
+	return true;
+}
+
+
+void baseFreeLayout::copySlots(baseFreeLayout &layout)
+{
+	layout.sparse = sparse;
+	layout.sparseSize = sparseSize;
+	layout.elements.resize(elements.size(), 0);
+	layout.fullSlots.resize(elements.size());
+	layout.elementCount = elementCount;
+	layout.highestFullSlot = highestFullSlot;
+	layout.lowestEmptySlot = lowestEmptySlot;
+	layout.markDrawOrderDirty();
+	layout.markBoundsDirty();
+}
+
+
+bool baseFreeLayout::contains(baseElement &element)
+{
+	for (baseFreeLayout *layout = element.parentLayout ; layout ;
+		layout = layout->parentLayout)
+		if (layout == this)
+			return true;
+	return false;
+}
+
+
+bool baseFreeLayout::isFoundBefore(baseElement *element1,
+	baseElement *element2)
+{
+	int depth1 = 0, depth2 = 0;
+	for (baseElement *e = element1 ; e->parentLayout != this ;
+		e = e->parentLayout)
+		depth1 ++;
+	for (baseElement *e = element2 ; e->parentLayout != this ;
+		e = e->parentLayout)
+		depth2 ++;
+
+	// If one element contains the other, it's found first.
+	for ( ; depth1 > depth2 ; depth1 --)
+	{
+		element1 = element1->parentLayout;
+		if (element1 == element2)
+			return false;
+	}
+	for ( ; depth2 > depth1 ; depth2 --)
+	{
+		element2 = element2->parentLayout;
+		if (element2 == element1)
+			return true;
+	}
+
+	// Otherwise, the slots of their ancestors in the same layout decide.
+	while (element1->parentLayout != element2->parentLayout)
+	{
+		element1 = element1->parentLayout;
+		element2 = element2->parentLayout;
+	}
+	return element1->slotNumber < element2->slotNumber;
+}
+
+
+baseElement* baseFreeLayout::findByName(const char *elementName,
+	std::size_t length)
+{
+	baseElement *e = 0;
+	if (length == 0)
+	{
+		// Elements without a name aren't indexed, so they're searched for.
+		layoutIterator it(*this);
+		for (it.next() ; !it.is_done() ; it.next())
+			if (it->name.empty())
+				return it.get_element();
+		return 0;
+	}
+
+	// The outermost layout indexes the elements of every layout inside it,
+	// so those outside this one are skipped.
+	baseFreeLayout *layout = indexingLayout();
+	const nameIndex::entryList &found =
+		layout->names.find(nameIndex::hash(elementName, length));
+	for (int i = 0 ; i < found.size() ; i ++)
+		if (nameIndex::has_name(*found[i], elementName, length) &&
+			(layout == this || contains(*found[i])) &&
+			(!e || isFoundBefore(found[i], e)))
+			e = found[i];
+	return e;
+}
+
+
+void baseFreeLayout::markDrawOrderDirty()
+{
+	drawOrderDirty = true;
+	for (baseFreeLayout *layout = this ; layout && !layout->drawTreeDirty ;
+		layout = layout->parentLayout)
+		layout->drawTreeDirty = true;
+}
+
+
+void baseFreeLayout::markSlotsDirty()
+{
+	slotsDirty = true;
+	markLayoutDirty();
+}
+
+
+void baseFreeLayout::includeBounds(float minX, float minY, float maxX,
+	float maxY)
+{
+	boundsMinX = std::min(boundsMinX, minX);
+	boundsMinY = std::min(boundsMinY, minY);
+	boundsMaxX = std::max(boundsMaxX, maxX);
+	boundsMaxY = std::max(boundsMaxY, maxY);
+}
+
+
+void baseFreeLayout::includeFrame(float posX, float posY, float width,
+	float height)
+{
+	includeBounds(std::min(posX, posX + width), std::min(posY, posY + height),
+		std::max(posX, posX + width), std::max(posY, posY + height));
+}
+
+
+void baseFreeLayout::calculateBounds()
+{
+	boundsMinX = boundsMaxX = slotPosX;
+	boundsMinY = boundsMaxY = slotPosY;
+	includeFrame(slotPosX, slotPosY, slotWidth, slotHeight);
+	includeFrame(contentPosX, contentPosY, contentWidth, contentHeight);
+	elementRange range(elements, fullSlots);
+	for (elementRange::iterator it = range.begin() ; it != range.end() ; it ++)
+		if (baseFreeLayout *layout = it->as_layout())
+			includeBounds(layout->boundsMinX, layout->boundsMinY,
+				layout->boundsMaxX, layout->boundsMaxY);
+		else
+		{
+			includeFrame(it->slotPosX, it->slotPosY, it->slotWidth,
+				it->slotHeight);
+			includeFrame(it->contentPosX, it->contentPosY, it->contentWidth,
+				it->contentHeight);
+			it->boundsDirty = false;
+		}
+	boundsDirty = false;
+}
+
+
+void baseFreeLayout::updateBounds()
+{
+	if (!boundsDirty)
+		return;
+
+	// Marked layouts are found in pre-order and recalculated in reverse, so
+	// the sublayouts of each one are recalculated before it.
+	std::vector<baseFreeLayout*> marked;
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+		if (baseFreeLayout *layout = it->as_layout())
+		{
+			if (layout->boundsDirty)
+				marked.push_back(layout);
+			else
+				it.skip_children();
+		}
+	for (int i = marked.size() - 1 ; i >= 0 ; i --)
+		marked[i]->calculateBounds();
+}
+
+
+bool baseFreeLayout::hitTestContent(const positionArguments &position,
+	std::vector<baseElement*> &path)
+{
+	// Every layout being searched is kept with the position in its drawing
+	// order of the next element to try. The topmost elements are the last
+	// ones drawn, so they're tried first.
+	std::vector<std::pair<baseFreeLayout*, int> > layouts;
+	layouts.push_back(std::make_pair(this, int(get_draw_order().size()) - 1));
+	while (!layouts.empty())
+	{
+		baseFreeLayout *layout = layouts.back().first;
+		int i = layouts.back().second --;
+		if (i < 0)
+		{
+			// Nothing inside the layout contains the position, but its own
+			// frames still may (except for this one's, checked by the caller).
+			layouts.pop_back();
+			if (layouts.empty())
+				return false;
+			if (position_inside_slot_frame(*layout, position) ||
+				position_inside_content_frame(*layout, position))
+				return true;
+			path.pop_back();
+			continue;
+		}
+
+		baseElement *e = layout->get_draw_order()[i];
+		baseFreeLayout *sublayout = e->as_layout();
+		if (sublayout)
+		{
+			// Nothing in the sublayout can contain the position if its
+			// subtree bounds don't.
+			if (position.posX >= sublayout->boundsMinX &&
+				position.posX <= sublayout->boundsMaxX &&
+				position.posY >= sublayout->boundsMinY &&
+				position.posY <= sublayout->boundsMaxY)
+			{
+				path.push_back(e);
+				layouts.push_back(std::make_pair(sublayout,
+					int(sublayout->get_draw_order().size()) - 1));
+			}
+		}
+		else if (position_inside_slot_frame(*e, position) ||
+			position_inside_content_frame(*e, position))
+		{
+			path.push_back(e);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void baseFreeLayout::recalculateSlotBounds(baseElement &element)
+{
+}
+
+
+bool baseFreeLayout::calculateSlotRects(float * /*slotPosX*/,
+	float * /*slotPosY*/, float * /*slotWidth*/, float * /*slotHeight*/)
+{
+	return false;
+}
+
+
+void baseFreeLayout::recalculateAllSlotBounds()
+{
+	int size = elements.size();
+	if (size == 0)
+		return;
+
+	if (slotScratch.size() < size * 4)
+		slotScratch.resize(size * 4);
+	float *slotPosX = &slotScratch[0], *slotPosY = slotPosX + size;
+	float *slotWidth = slotPosY + size, *slotHeight = slotWidth + size;
+	if (!calculateSlotRects(slotPosX, slotPosY, slotWidth, slotHeight))
+	{
+		for (int i = 0 ; i < size ; i ++)
+			if (elements[i])
+				recalculateSlotBounds(*elements[i]);
+		return;
+	}
+
+	// Content is aligned in blocks small enough for the elements read to
+	// still be cached when the results are applied to them.
+	const int blockSize = 256;
+	float contentWidth[blockSize], contentHeight[blockSize];
+	float contentPosX[blockSize], contentPosY[blockSize];
+	int alignmentX[blockSize], alignmentY[blockSize];
+	for (int first = 0 ; first < size ; first += blockSize)
+	{
+		int count = std::min(blockSize, size - first);
+		for (int i = 0 ; i < count ; i ++)
+		{
+			baseElement *e = elements[first + i];
+			if (e)
+			{
+				contentWidth[i] = e->contentWidth;
+				contentHeight[i] = e->contentHeight;
+				contentPosX[i] = e->contentPosX;
+				contentPosY[i] = e->contentPosY;
+				alignmentX[i] = e->alignmentX;
+				alignmentY[i] = e->alignmentY;
+			}
+			else
+			{
+				contentWidth[i] = contentHeight[i] = 0;
+				contentPosX[i] = contentPosY[i] = 0;
+				alignmentX[i] = alignmentY[i] = none;
+			}
+		}
+		alignContent(count, slotPosX + first, slotWidth + first, contentWidth,
+			alignmentX, contentPosX, left, right);
+		alignContent(count, slotPosY + first, slotHeight + first,
+			contentHeight, alignmentY, contentPosY, top, bottom);
+		for (int i = 0 ; i < count ; i ++)
+			if (elements[first + i])
+				elements[first + i]->applySlotBounds(slotPosX[first + i],
+					slotPosY[first + i], slotWidth[first + i],
+					slotHeight[first + i], contentPosX[i], contentPosY[i]);
+	}
+}
+
+
+baseFreeLayout::baseFreeLayout(int size, ALIGNMENT defaultAlignmentX,
+	ALIGNMENT defaultAlignmentY, bool elastic, bool sparse)
+{
+	thisLayout = this;
+	if (size < 0)
+		size = 0;
+	this->sparse = sparse;
+	sparseSize = sparse ? size : 0;
+	sparseDensity = 0;
+	if (!sparse)
+	{
+		elements.resize(size);
+		fullSlots.resize(size);
+	}
+	this->defaultAlignmentX = defaultAlignmentX;
+	this->defaultAlignmentY = defaultAlignmentY;
+	this->elastic = elastic;
+	elementCount = 0;
+	lowestEmptySlot = 0;
+	highestFullSlot = -1;
+	slotsDirty = false;
+	updateDepth = 0;
+	drawOrderDirty = false;
+	drawTreeDirty = true;
+}
+
+
+baseFreeLayout::~baseFreeLayout()
+{
+}
+
+
+int baseFreeLayout::get_size()
+{
+	return sparse ? sparseSize : elements.size();
+}
+
+
+int baseFreeLayout::get_element_count()
+{
+	return elementCount;
+}
+
+
+int baseFreeLayout::get_lowest_empty_slot()
+{
+	return lowestEmptySlot;
+}
+
+
+int baseFreeLayout::get_highest_full_slot()
+{
+	return highestFullSlot;
+}
+
+
+int baseFreeLayout::get_next_empty_slot(int slotNumber)
+{
+	if (!sparse)
+		return fullSlots.find_next_cleared(slotNumber);
+	// The elements from the given slot on are followed while their slots are
+	// consecutive.
+	slotNumber = std::max(slotNumber, 0);
+	for (int i = findPosition(slotNumber) ; i < elements.size() &&
+		elements[i]->slotNumber == slotNumber ; i ++)
+		slotNumber ++;
+	return std::min(slotNumber, sparseSize);
+}
+
+
+int baseFreeLayout::get_next_full_slot(int slotNumber)
+{
+	if (!sparse)
+		return fullSlots.find_next_set(slotNumber);
+	int position = findPosition(slotNumber);
+	return position < elements.size() ? elements[position]->slotNumber :
+		sparseSize;
+}
+
+
+int baseFreeLayout::count_full_slots(int firstSlot, int lastSlot)
+{
+	if (!sparse)
+		return fullSlots.count(firstSlot, lastSlot);
+	return std::max(0, findPosition(lastSlot) - findPosition(firstSlot));
+}
+
+
+ALIGNMENT baseFreeLayout::get_default_alignment_x()
+{
+	return defaultAlignmentX;
+}
+
+
+ALIGNMENT baseFreeLayout::get_default_alignment_y()
+{
+	return defaultAlignmentY;
+}
+
+
+bool baseFreeLayout::get_elasticity()
+{
+	return elastic;
+}
+
+
+bool baseFreeLayout::get_sparse()
+{
+	return sparse;
+}
+
+
+float baseFreeLayout::get_sparse_density()
+{
+	return sparseDensity;
+}
+
+
+bool baseFreeLayout::is_slot_full(int slotNumber)
+{
+	return baseFreeLayout::get_element(slotNumber) != 0;
+}
+
+
+baseElement* baseFreeLayout::get_element(int slotNumber)
+{
+	baseElement* e = 0;
+	if (sparse)
+	{
+		int position = findPosition(slotNumber);
+		if (slotNumber >= 0 && position < elements.size() &&
+			elements[position]->slotNumber == slotNumber)
+			e = elements[position];
+	}
+	else if (slotNumber >= 0 && slotNumber < elements.size())
+		e = elements[slotNumber];
+	return e;
+}
+
+
+std::vector<baseElement*> baseFreeLayout::get_elements()
+{
+	if (!sparse)
+		return elements;
+	std::vector<baseElement*> slots(sparseSize, 0);
+	for (int i = 0 ; i < elements.size() ; i ++)
+		slots[elements[i]->slotNumber] = elements[i];
+	return slots;
+}
+
+
+elementRange baseFreeLayout::get_element_range()
+{
+	return elementRange(elements, fullSlots);
+}
+
+
+std::vector<baseElement*>& baseFreeLayout::get_draw_order()
+{
+	if (drawOrderDirty)
+		sortDrawOrder();
+	return drawOrder;
+}
+
+
+bool baseFreeLayout::get_draw_tree_dirty()
+{
+	return drawTreeDirty;
+}
+
+
+void baseFreeLayout::clear_draw_tree_dirty()
+{
+	drawTreeDirty = false;
+}
+
+
+bool baseFreeLayout::traverse(layoutVisitor &visitor, TRAVERSAL order)
+{
+	for (layoutIterator it(*this, order) ; !it.is_done() ; it.next())
+		if (!visitor.visit(*it))
+			return false;
+	return true;
+}
+
+
+baseElement* baseFreeLayout::hit_test(float posX, float posY)
+{
+	std::vector<baseElement*> path;
+	return hit_test(posX, posY, path);
+}
+
+
+bool baseFreeLayout::route_event(std::string eventName, float posX,
+	float posY, std::map<std::string, void*> &conditionArgs,
+	std::map<std::string, void*> &effectArgs)
+{
+	const void *positionType =
+		typedEventBase<positionArguments>::arguments_type();
+	positionArguments position;
+	position.posX = posX;
+	position.posY = posY;
+	bool fulfilled = false;
+	std::vector<baseElement*> path;
+	hit_test(posX, posY, path);
+	// The event bubbles up from the element found to the layout.
+	for (int i = path.size() - 1 ; i >= 0 ; i --)
+		if (event *e = path[i]->find_event(eventName))
+		{
+			bool done = e->argumentsType == positionType ?
+				static_cast<typedEventBase<positionArguments>*>(e)->activate(
+				*path[i], position) : e->activate(conditionArgs, effectArgs);
+			fulfilled = fulfilled || done;
+			if (done && !e->propagates)
+				break;
+		}
+	return fulfilled;
+}
+
+
+baseElement* baseFreeLayout::hit_test(float posX, float posY,
+	std::vector<baseElement*> &path)
+{
+	positionArguments position;
+	position.posX = posX;
+	position.posY = posY;
+	path.clear();
+	update_layout();
+	updateBounds();
+	if (posX >= boundsMinX && posX <= boundsMaxX && posY >= boundsMinY &&
+		posY <= boundsMaxY)
+	{
+		path.push_back(this);
+		if (hitTestContent(position, path) ||
+			position_inside_slot_frame(*this, position) ||
+			position_inside_content_frame(*this, position))
+			return path.back();
+		path.clear();
+	}
+	return 0;
+}
+
+
+void baseFreeLayout::set_content_position(float contentPosX, float contentPosY)
+{
+	baseElement::set_content_position(contentPosX, contentPosY);
+	markSlotsDirty();
+}
+
+
+void baseFreeLayout::set_content_size(float contentWidth, float contentHeight)
+{
+	baseElement::set_content_size(contentWidth, contentHeight);
+	markSlotsDirty();
+}
+
+
+void baseFreeLayout::r_match_content_to_slot()
+{
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+		it->match_content_to_slot();
+}
+
+
+void baseFreeLayout::r_match_slot_to_content()
+{
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+		it->match_slot_to_content();
+}
+
+
+void baseFreeLayout::set_default_alignment_x(ALIGNMENT defaultAlignmentX)
+{
+	if (defaultAlignmentX == none || defaultAlignmentX == left ||
+		defaultAlignmentX == right || defaultAlignmentX == center ||
+		defaultAlignmentX == keep)
+		this->defaultAlignmentX = defaultAlignmentX;
+}
+
+
+void baseFreeLayout::set_default_alignment_y(ALIGNMENT defaultAlignmentY)
+{
+	if (defaultAlignmentY == none || defaultAlignmentY == top ||
+		defaultAlignmentY == bottom || defaultAlignmentY == center ||
+		defaultAlignmentY == keep)
+		this->defaultAlignmentY = defaultAlignmentY;
+}
+
+
+void baseFreeLayout::set_default_alignment(ALIGNMENT defaultAlignmentX,
+	ALIGNMENT defaultAlignmentY)
+{
+	if (defaultAlignmentX == none || defaultAlignmentX == left ||
+		defaultAlignmentX == right || defaultAlignmentX == center ||
+		defaultAlignmentX == keep)
+		this->defaultAlignmentX = defaultAlignmentX;
+	if (defaultAlignmentY == none || defaultAlignmentY == top ||
+		defaultAlignmentY == bottom || defaultAlignmentY == center ||
+		defaultAlignmentY == keep)
+		this->defaultAlignmentY = defaultAlignmentY;
+}
+
+
+void baseFreeLayout::r_align()
+{
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+		it->align();
+}
+
+
+void baseFreeLayout::r_align(ALIGNMENT alignmentX, ALIGNMENT alignmentY)
+{
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+		it->align(alignmentX, alignmentY);
+}
+
+
+bool baseFreeLayout::is_updating()
+{
+	return openUpdateScopes > 0 && (updateDepth > 0 ||
+		(parentLayout && parentLayout->is_updating()));
+}
+
+
+void baseFreeLayout::update_layout()
+{
+	if (!layoutDirty || is_updating())
+		return;
+	// Reached from a parallel update, large layouts split their work again.
+	if (updatePool && estimateWork() >= updateGrainSize)
+	{
+		updateInParallel(*updatePool, updateQueue, updateGrainSize);
+		return;
+	}
+
+	// Marked elements are updated in pre-order, without recursion. The layouts
+	// being updated are kept by level, as each one is unmarked only when the
+	// traversal leaves it, so marks made by the elements inside during the
+	// update don't spread to the layouts containing it.
+	std::vector<baseFreeLayout*> openLayouts;
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+	{
+		baseElement &element = *it;
+		for ( ; openLayouts.size() > it.get_level() ; openLayouts.pop_back())
+			openLayouts.back()->layoutDirty = false;
+
+		baseFreeLayout *layout = element.as_layout();
+		if (!element.layoutDirty || element.is_updating())
+			it.skip_children();
+		else if (!layout)
+			element.update_layout();
+		else
+		{
+			// The layout's own content is aligned first, since slots depend on
+			// it.
+			if (layout->alignmentDirty)
+				layout->align();
+			// Slots are recalculated next, since that may mark elements inside.
+			if (layout->slotsDirty)
+			{
+				layout->slotsDirty = false;
+				layout->recalculateAllSlotBounds();
+			}
+			openLayouts.push_back(layout);
+		}
+	}
+	for ( ; !openLayouts.empty() ; openLayouts.pop_back())
+		openLayouts.back()->layoutDirty = false;
+}
+
+
+thread_local threadPool* baseFreeLayout::updatePool = 0;
+
+
+thread_local int baseFreeLayout::updateQueue = 0;
+
+
+thread_local int baseFreeLayout::updateGrainSize = 0;
+
+
+int baseFreeLayout::estimateWork()
+{
+	int work = 0;
+	elementRange range(elements, fullSlots);
+	for (elementRange::iterator it = range.begin() ; it != range.end() ; it ++)
+		work += it->as_layout() ? 1 + it->as_layout()->elements.size() : 1;
+	return work;
+}
+
+
+void baseFreeLayout::updateInParallel(threadPool &pool, int queue,
+	int grainSize)
+{
+	// The layout's own content and slots are updated first, as in
+	// 'update_layout'. After that, the elements inside are independent.
+	if (alignmentDirty)
+		align();
+	if (slotsDirty)
+	{
+		slotsDirty = false;
+		recalculateAllSlotBounds();
+	}
+	// The flags shared by the tasks are set beforehand, so that marks made by
+	// elements updated in different threads stop at this layout, which tasks
+	// only read. Layouts containing a marked one are already marked.
+	for (baseElement *e = this ; e && !e->boundsDirty ; e = e->parentLayout)
+		e->boundsDirty = true;
+	for (baseElement *e = this ; e && !e->layoutDirty ; e = e->parentLayout)
+		e->layoutDirty = true;
+
+	// Elements are split into ranges of consecutive slots with about
+	// 'grainSize' work each.
+	std::vector<updateRange> ranges;
+	updateRange range = {this, 0, 0, &pool, grainSize};
+	int work = 0;
+	for (int i = fullSlots.find_next_set(0) ; i < elements.size() ;
+		i = fullSlots.find_next_set(i + 1))
+	{
+		baseFreeLayout *layout = elements[i]->as_layout();
+		work += layout ? 1 + layout->elements.size() : 1;
+		if (work >= grainSize)
+		{
+			range.last = i + 1;
+			ranges.push_back(range);
+			range.first = i + 1;
+			work = 0;
+		}
+	}
+	range.last = elements.size();
+	if (range.first < range.last)
+		ranges.push_back(range);
+
+	// The first range is updated by this thread, while the others wait in its
+	// queue for idle threads to steal them.
+	threadPool::taskCounter pending(ranges.size() > 1 ? ranges.size() - 1 : 0);
+	for (int i = 1 ; i < ranges.size() ; i ++)
+		pool.submit(updateRangeTask, &ranges[i], pending, queue);
+	if (!ranges.empty())
+		updateRangeTask(&ranges[0], queue);
+	pool.wait(pending, queue);
+	layoutDirty = false;
+}
+
+
+void baseFreeLayout::updateRangeTask(void *range, int queue)
+{
+	updateRange &slots = *static_cast<updateRange*>(range);
+	std::vector<baseElement*> &elements = slots.layout->elements;
+	slotBitset &fullSlots = slots.layout->fullSlots;
+
+	// The thread may be waiting for another update, whose context is restored
+	// afterwards.
+	threadPool *oldPool = updatePool;
+	int oldQueue = updateQueue, oldGrainSize = updateGrainSize;
+	updatePool = slots.pool;
+	updateQueue = queue;
+	updateGrainSize = slots.grainSize;
+	for (int i = fullSlots.find_next_set(slots.first) ; i < slots.last ;
+		i = fullSlots.find_next_set(i + 1))
+		if (elements[i]->layoutDirty)
+			elements[i]->update_layout();
+	updatePool = oldPool;
+	updateQueue = oldQueue;
+	updateGrainSize = oldGrainSize;
+}
+
+
+void baseFreeLayout::update_layout(threadPool &pool, int grainSize)
+{
+	if (!layoutDirty || is_updating())
+		return;
+	if (pool.get_number_of_threads() < 2 || estimateWork() < grainSize)
+	{
+		update_layout();
+		return;
+	}
+	// The layout goes through its own 'update_layout' too, which splits the
+	// work once the pool is set.
+	threadPool *oldPool = updatePool;
+	int oldQueue = updateQueue, oldGrainSize = updateGrainSize;
+	updatePool = &pool;
+	updateQueue = 0;
+	updateGrainSize = grainSize;
+	parallelUpdates ++;
+	update_layout();
+	parallelUpdates --;
+	updatePool = oldPool;
+	updateQueue = oldQueue;
+	updateGrainSize = oldGrainSize;
+}
+
+
+void baseFreeLayout::begin_update()
+{
+	if (updateDepth == 0)
+		openUpdateScopes ++;
+	updateDepth ++;
+}
+
+
+void baseFreeLayout::end_update()
+{
+	if (updateDepth > 0)
+	{
+		updateDepth --;
+		if (updateDepth == 0)
+		{
+			openUpdateScopes --;
+			// Pending changes are applied only when the outermost scope closes.
+			if (!is_updating())
+				update_layout();
+		}
+	}
+}
+
+
+void baseFreeLayout::copy(baseFreeLayout &layout)
+{
+	baseElement::copy(layout);
+	layout.defaultAlignmentX = defaultAlignmentX;
+	layout.defaultAlignmentY = defaultAlignmentY;
+	layout.elastic = elastic;
+	layout.sparseDensity = sparseDensity;
+	layout.set_sparse(sparse);
+	layout.markSlotsDirty();
+}
+
+
+void baseFreeLayout::r_copy(baseFreeLayout &layout)
+{
+	baseFreeLayout::copy(layout);
+	// Existing elements in the received layout are removed from it first,
+	// from the last one (so that none are moved with sparse storage).
+	while (layout.elementCount > 0)
+		layout.baseFreeLayout::remove_element(layout.highestFullSlot);
+
+	// Every element inside is cloned on its own (without the elements inside
+	// it). Elements are visited in post-order, so the copies of the elements
+	// inside a layout are kept by level until the layout is copied, and then
+	// put in it. Building the copy bottom-up keeps 'indexElement' from walking
+	// up the whole copy for every element.
+	std::vector<std::vector<baseElement*> > copies;
+	for (layoutIterator it(*this, postorder) ; !it.is_done() ; it.next())
+	{
+		baseElement &element = *it;
+		int level = it.get_level();
+		baseElement *newElement = &layout;
+		if (level > 0)
+		{
+			newElement = element.clone();
+			newElement->slotNumber = element.slotNumber;
+		}
+		if (copies.size() < level + 2)
+			copies.resize(level + 2);
+
+		if (baseFreeLayout *elementLayout = element.as_layout())
+		{
+			baseFreeLayout *newLayout = newElement->as_layout();
+			elementLayout->copySlots(*newLayout);
+			std::vector<baseElement*> &inside = copies[level + 1];
+			// With sparse storage, elements are put in the same order.
+			for (int i = 0 ; i < inside.size() ; i ++)
+			{
+				int position = newLayout->sparse ? i : inside[i]->slotNumber;
+				newLayout->elements[position] = inside[i];
+				newLayout->fullSlots.set(position);
+				inside[i]->parentLayout = newLayout;
+				newLayout->indexElement(*inside[i]);
+			}
+			inside.clear();
+		}
+		if (level > 0)
+			copies[level].push_back(newElement);
+	}
+}
+
+
+void baseFreeLayout::set_size(int size)
+{
+	if (size >= 0)
+	{
+		resizeElements(size);
+		checkDensity();
+	}
+}
+
+
+void baseFreeLayout::set_elasticity(bool elastic)
+{
+	this->elastic = elastic;
+}
+
+
+void baseFreeLayout::set_sparse(bool sparse)
+{
+	if (!sparse || supportsSparseSlots())
+		convertStorage(sparse);
+}
+
+
+void baseFreeLayout::set_sparse_density(float sparseDensity)
+{
+	this->sparseDensity = std::max(0.0f, sparseDensity);
+	checkDensity();
+}
+
+
+void baseFreeLayout::compact()
+{
+	// Elements are moved down over the empty slots before them.
+	int count = 0;
+	if (sparse)
+		for ( ; count < elements.size() ; count ++)
+			elements[count]->slotNumber = count;
+	else
+		for (int i = fullSlots.find_next_set(0) ; i < elements.size() ;
+			i = fullSlots.find_next_set(i + 1), count ++)
+			if (i != count)
+			{
+				elements[count] = elements[i];
+				elements[count]->slotNumber = count;
+				elements[i] = 0;
+				fullSlots.reset(i);
+				fullSlots.set(count);
+			}
+	if (elastic)
+	{
+		if (sparse)
+			sparseSize = count;
+		else
+		{
+			elements.resize(count);
+			fullSlots.resize(count);
+		}
+	}
+	lowestEmptySlot = count;
+	highestFullSlot = count - 1;
+	markDrawOrderDirty();
+	markSlotsDirty();
+	if (!is_updating())
+	{
+		slotsDirty = false;
+		recalculateAllSlotBounds();
+	}
+	checkDensity();
+}
+
+
+baseElement* baseFreeLayout::find_element(long long elementId)
+{
+	// The layout itself isn't a candidate.
+	layoutIterator it(*this);
+	for (it.next() ; !it.is_done() ; it.next())
+		if (it->get_id() == elementId)
+			return it.get_element();
+	return 0;
+}
+
+
+baseElement* baseFreeLayout::find_element(const std::string &elementName)
+{
+	return findByName(elementName.data(), elementName.size());
+}
+
+
+baseElement* baseFreeLayout::find_element(const char *elementName)
+{
+	return findByName(elementName, std::char_traits<char>::length(elementName));
+}
+
+
+#ifdef LAYOUT_STRING_VIEW
+baseElement* baseFreeLayout::find_element(std::string_view elementName)
+{
+	return findByName(elementName.data(), elementName.size());
+}
+#endif
+
+
+void baseFreeLayout::add_element(baseElement &element)
+{
+	add_element(element, lowestEmptySlot);
+}
+
+
+void baseFreeLayout::add_element(baseElement &element, int slotNumber)
+{
+	if (slotNumber >= 0 && !element.parentLayout &&
+		(elastic || slotNumber < get_size()))
+	{
+		// The size of an elastic layout is expanded if necessary.
+		growElements(slotNumber + 1);
+		placeElement(element, slotNumber);
+
+		// The new element's slot and alignment are recalculated (its slot
+		// number must already be set for that).
+		// While updates are suspended, or if the layout grew (which changes
+		// every slot in positional layouts), all slots are recalculated at
+		// once later.
+		if (is_updating() || slotsDirty)
+			markSlotsDirty();
+		else
+			recalculateSlotBounds(element);
+
+		// The lowest empty slot and the highest full slot are recalculated.
+		if (slotNumber == lowestEmptySlot)
+			lowestEmptySlot = get_next_empty_slot(slotNumber);
+		if (slotNumber > highestFullSlot)
+			highestFullSlot = slotNumber;
+		checkDensity();
+	}
+}
+
+
+void baseFreeLayout::add_elements(const std::vector<baseElement*> &newElements)
+{
+	placeElements(newElements, -1);
+}
+
+
+void baseFreeLayout::add_elements(const std::vector<baseElement*> &newElements,
+	int slotNumber)
+{
+	if (slotNumber >= 0)
+		placeElements(newElements, slotNumber);
+}
+
+
+void baseFreeLayout::reserve(int size)
+{
+	if (size > 0)
+		elements.reserve(size);
+}
+
+
+baseElement* baseFreeLayout::remove_element(int slotNumber)
+{
+	baseElement *e = baseFreeLayout::get_element(slotNumber);
+	if (e)
+	{
+		// The position must be found before the slot number is reset.
+		int position = sparse ? findPosition(slotNumber) : slotNumber;
+		unindexElement(*e);
+		e->parentLayout = 0;
+		e->slotNumber = -1;
+		if (sparse)
+		{
+			elements.erase(elements.begin() + position);
+			fullSlots.resize(elements.size());
+		}
+		else
+		{
+			elements[slotNumber] = 0;
+			fullSlots.reset(slotNumber);
+		}
+		elementCount --;
+		markDrawOrderDirty();
+		markBoundsDirty();
+		if (slotNumber < lowestEmptySlot)
+			lowestEmptySlot = slotNumber;
+		if (slotNumber == highestFullSlot)
+			highestFullSlot = sparse ? (elements.empty() ? -1 :
+				elements.back()->slotNumber) :
+				fullSlots.find_previous_set(slotNumber);
+	}
+	return e;
+}
+
+
+void baseFreeLayout::remove_element(baseElement &element)
+{
+	// We check thet the element is indeed in the layout.
+	bool inLayout = false;
+	for (baseFreeLayout *l = element.parentLayout ; l && !inLayout ;
+		l = l->parentLayout)
+		if (l == this)
+			inLayout = true;
+	// We remove the element.
+	if (inLayout)
+		element.parentLayout->remove_element(element.slotNumber);
+}
+
+
+void baseFreeLayout::r_delete()
+{
+	// In post-order, each element is deleted after the elements inside it, and
+	// the traversal moves on before deleting it. The layout itself is last.
+	layoutIterator it(*this, postorder);
+	while (!it.is_done())
+	{
+		baseElement *e = it.get_element();
+		it.next();
+		delete e;
+	}
+}
+
+
+void baseFreeLayout::r_set_geometry_store(geometryStore &store)
+{
+	for (layoutIterator it(*this) ; !it.is_done() ; it.next())
+		it->set_geometry_store(store);
+}
+
+
+/* CLASS updateScope */
+
+
+updateScope::updateScope(baseFreeLayout &layout)
+{
+	this->layout = &layout;
+	layout.begin_update();
+}
+
+
+updateScope::~updateScope()
+{
+	layout->end_update();
+}
+
+
+/* CLASS threadPool */
+
+
+bool threadPool::takeTask(int queue, task &found)
+{
+	if (queuedTasks == 0)
+		return false;
+	for (int i = 0 ; i < queues.size() ; i ++)
+	{
+		// The thread's own queue is checked first, then the next ones in turn.
+		int victim = (queue + i) % queues.size();
+		std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+		std::deque<task> &tasks = queues[victim]->tasks;
+		if (!tasks.empty())
+		{
+			// Own tasks are taken from the back, where the most recent ones
+			// are, and stolen ones from the front.
+			if (i == 0)
+			{
+				found = tasks.back();
+				tasks.pop_back();
+			}
+			else
+			{
+				found = tasks.front();
+				tasks.pop_front();
+			}
+			queuedTasks --;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void threadPool::runTask(task &found, int queue)
+{
+	found.function(found.argument, queue);
+	if (-- (*found.counter) == 0)
+	{
+		// As in 'submit', the lock makes sure that a thread about to sleep in
+		// 'wait' either sees the counter at 0, or is notified.
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		groupDone.notify_all();
+	}
+}
+
+
+void threadPool::work(int queue)
+{
+	task found;
+	while (true)
+	{
+		if (takeTask(queue, found))
+			runTask(found, queue);
+		else
+		{
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			while (!stopping && queuedTasks == 0)
+				wakeUp.wait(lock);
+			if (stopping)
+				return;
+		}
+	}
+}
+
+
+threadPool::threadPool(int numberOfThreads)
+{
+	if (numberOfThreads <= 0)
+		numberOfThreads = std::thread::hardware_concurrency();
+	if (numberOfThreads <= 0)
+		numberOfThreads = 1;
+	queuedTasks = 0;
+	stopping = false;
+	for (int i = 0 ; i < numberOfThreads ; i ++)
+		queues.push_back(new taskQueue());
+	for (int i = 1 ; i < numberOfThreads ; i ++)
+		threads.push_back(std::thread(&threadPool::work, this, i));
+}
+
+
+threadPool::~threadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (int i = 0 ; i < threads.size() ; i ++)
+		threads[i].join();
+	for (int i = 0 ; i < queues.size() ; i ++)
+		delete queues[i];
+}
+
+
+int threadPool::get_number_of_threads()
+{
+	return queues.size();
+}
+
+
+void threadPool::submit(taskFunction function, void *argument,
+	taskCounter &counter, int queue)
+{
+	task newTask = {function, argument, &counter};
+	{
+		std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+		queues[queue]->tasks.push_back(newTask);
+	}
+	queuedTasks ++;
+	// The lock makes sure that a worker about to sleep either sees the new
+	// task, or is already waiting when it's notified.
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	wakeUp.notify_one();
+	groupDone.notify_all();
+}
+
+
+void threadPool::wait(taskCounter &counter, int queue)
+{
+	task found;
+	while (counter > 0)
+		if (takeTask(queue, found))
+			runTask(found, queue);
+		else
+		{
+			// The remaining tasks are running in other threads, which may
+			// still submit more.
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			while (counter > 0 && queuedTasks == 0)
+				groupDone.wait(lock);
+		}
+}
+
+
+/* CLASS layoutIterator */
+
+
+baseElement* layoutIterator::nextChild(frame &layoutFrame)
+{
+	if (order == depthorder)
+	{
+		// The draw order is asked for on every step, as it may be sorted again
+		// while elements are visited.
+		std::vector<baseElement*> &children =
+			layoutFrame.layout->get_draw_order();
+		if (layoutFrame.index < children.size())
+			return children[layoutFrame.index ++];
+		return 0;
+	}
+	// Runs of empty slots are skipped at once.
+	baseFreeLayout *layout = layoutFrame.layout;
+	if (layoutFrame.index < layout->elements.size() &&
+		!layout->elements[layoutFrame.index])
+		layoutFrame.index = layout->fullSlots.find_next_set(layoutFrame.index);
+	if (layoutFrame.index < layout->elements.size())
+		return layout->elements[layoutFrame.index ++];
+	return 0;
+}
+
+
+void layoutIterator::descendPostorder()
+{
+	while (baseFreeLayout *layout = current->as_layout())
+	{
+		frame layoutFrame = {layout, 0};
+		frames.push_back(layoutFrame);
+		baseElement *child = nextChild(frames.back());
+		if (!child)
+		{
+			// Empty layouts are visited right away.
+			frames.pop_back();
+			return;
+		}
+		current = child;
+	}
+}
+
+
+layoutIterator::layoutIterator(baseElement &root, TRAVERSAL order)
+{
+	if (order != preorder && order != postorder && order != depthorder)
+		order = preorder;
+	this->order = order;
+	current = &root;
+	descend = true;
+	if (order == postorder)
+		descendPostorder();
+}
+
+
+layoutIterator::~layoutIterator()
+{
+}
+
+
+baseElement* layoutIterator::get_element()
+{
+	return current;
+}
+
+
+int layoutIterator::get_level()
+{
+	// Only the layouts containing the current element are in the stack.
+	return frames.size();
+}
+
+
+bool layoutIterator::is_done()
+{
+	return current == 0;
+}
+
+
+void layoutIterator::next()
+{
+	if (!current)
+		return;
+
+	if (order == postorder)
+	{
+		// The current element isn't read, as it may have been deleted.
+		if (frames.empty())
+			current = 0;
+		else if (baseElement *child = nextChild(frames.back()))
+		{
+			current = child;
+			descendPostorder();
+		}
+		else
+		{
+			current = frames.back().layout;
+			frames.pop_back();
+		}
+		return;
+	}
+
+	if (descend)
+		if (baseFreeLayout *layout = current->as_layout())
+		{
+			frame layoutFrame = {layout, 0};
+			frames.push_back(layoutFrame);
+		}
+	descend = true;
+	while (!frames.empty())
+	{
+		if (baseElement *child = nextChild(frames.back()))
+		{
+			current = child;
+			return;
+		}
+		frames.pop_back();
+	}
+	current = 0;
+}
+
+
+void layoutIterator::skip_children()
+{
+	descend = false;
+}
+
+
+baseElement& layoutIterator::operator*()
+{
+	return *current;
+}
+
+
+baseElement* layoutIterator::operator->()
+{
+	return current;
+}
+
+
+layoutIterator& layoutIterator::operator++()
+{
+	next();
+	return *this;
+}
+
+
+/* CLASS layoutVisitor */
+
+
+layoutVisitor::~layoutVisitor()
+{
+}
+
+
+/* CLASS baseHorizontalLayout */
+
+
+void baseHorizontalLayout::recalculateSlotBounds(baseElement &element)
+{
+	if (elements.size() > 0)
+	{
+		int slotNumber = element.get_slot_number();
+		float slotsWidth = contentWidth / elements.size();
+		element.set_slot_position(contentPosX + slotNumber * slotsWidth,
+			contentPosY);
+		element.set_slot_size(slotsWidth, contentHeight);
+	}
+}
+
+
+bool baseHorizontalLayout::calculateSlotRects(float *slotPosX,
+	float *slotPosY, float *slotWidth, float *slotHeight)
+{
+	int size = elements.size();
+	float slotsWidth = contentWidth / size;
+	fillSequence(slotPosX, size, contentPosX, slotsWidth);
+	std::fill(slotPosY, slotPosY + size, contentPosY);
+	std::fill(slotWidth, slotWidth + size, slotsWidth);
+	std::fill(slotHeight, slotHeight + size, contentHeight);
+	return true;
+}
+
+
+bool baseHorizontalLayout::supportsSparseSlots()
+{
+	return false;
+}
+
+
+baseHorizontalLayout::baseHorizontalLayout()
+{
+}
+
+
+baseHorizontalLayout::~baseHorizontalLayout()
+{
+}
+
+
+/* CLASS verticalLayout */
+
+
+void baseVerticalLayout::recalculateSlotBounds(baseElement &element)
+{
+	if (elements.size() > 0)
+	{
+		int slotNumber = element.get_slot_number();
+		float slotsHeight = contentHeight / elements.size(); 
+		element.set_slot_position(contentPosX, contentPosY + slotNumber *
+			slotsHeight);
+		element.set_slot_size(contentWidth, slotsHeight);
+	}
+}
+
+
+bool baseVerticalLayout::calculateSlotRects(float *slotPosX,
+	float *slotPosY, float *slotWidth, float *slotHeight)
+{
+	int size = elements.size();
+	float slotsHeight = contentHeight / size;
+	std::fill(slotPosX, slotPosX + size, contentPosX);
+	fillSequence(slotPosY, size, contentPosY, slotsHeight);
+	std::fill(slotWidth, slotWidth + size, contentWidth);
+	std::fill(slotHeight, slotHeight + size, slotsHeight);
+	return true;
+}
+
+
+bool baseVerticalLayout::supportsSparseSlots()
+{
+	return false;
+}
+
+
+baseVerticalLayout::baseVerticalLayout()
+{
+}
+
+
+baseVerticalLayout::~baseVerticalLayout()
+{
+}
+
+
+/* CLASS tableLayout */
+
+
+int baseTableLayout::getPoolLength(int count, float viewport, float cellSize)
+{
+	// The content frame is covered, plus a row or column partly out of view
+	// and 'overscan' on each side.
+	return std::min(count, (int) std::ceil(std::max(0.0f, viewport) /
+		cellSize) + 1 + 2 * overscan);
+}
+
+
+int baseTableLayout::getFirstShown(double scrollOffset, float cellSize,
+	int count, int poolLength)
+{
+	int first = (int) std::floor(scrollOffset / cellSize) - overscan;
+	return std::max(0, std::min(first, count - poolLength));
+}
+
+
+baseElement* baseTableLayout::createCell()
+{
+	return cellPrototype->r_clone();
+}
+
+
+void baseTableLayout::updateCells(bool rebindAll)
+{
+	int rows = 0, columns = 0;
+	if (cellPrototype && cellWidth > 0 && cellHeight > 0)
+	{
+		rows = getPoolLength(numberOfRows, contentHeight, cellHeight);
+		columns = getPoolLength(numberOfColumns, contentWidth, cellWidth);
+	}
+	int poolSize = rows * columns;
+	scrollOffsetX = std::max(0.0, std::min(scrollOffsetX,
+		get_max_scroll_offset_x()));
+	scrollOffsetY = std::max(0.0, std::min(scrollOffsetY,
+		get_max_scroll_offset_y()));
+
+	// The slot showing each cell depends on the size of the pool, so if it
+	// changes, cells left out are deleted and every cell is bound again.
+	if (rows != boundRows.size() || columns != boundColumns.size() ||
+		poolSize != elements.size())
+	{
+		for (int i = poolSize ; i < elements.size() ; i ++)
+			if (elements[i])
+				baseFreeLayout::remove_element(i)->r_delete();
+		resizeElements(poolSize);
+		boundRows.assign(rows, -1);
+		boundColumns.assign(columns, -1);
+	}
+	for (int i = 0 ; i < poolSize ; i ++)
+		if (!elements[i])
+			baseFreeLayout::add_element(*createCell(), i);
+	if (poolSize == 0)
+	{
+		firstRow = firstColumn = 0;
+		markSlotsDirty();
+		return;
+	}
+
+	// Each row (or column) of cells shows the only row (or column) from the
+	// first one on with its number as remainder. Only cells in a row or column
+	// of cells whose row or column has changed are bound again.
+	firstRow = getFirstShown(scrollOffsetY, cellHeight, numberOfRows, rows);
+	firstColumn = getFirstShown(scrollOffsetX, cellWidth, numberOfColumns,
+		columns);
+	std::vector<char> rowChanged(rows), rowInView(rows);
+	for (int i = 0 ; i < rows ; i ++)
+	{
+		int row = firstRow + (i - firstRow % rows + rows) % rows;
+		rowChanged[i] = rebindAll || boundRows[i] != row;
+		boundRows[i] = row;
+		double rowStart = (double) row * cellHeight;
+		rowInView[i] = rowStart < scrollOffsetY + contentHeight &&
+			rowStart + cellHeight > scrollOffsetY;
+	}
+	std::vector<char> columnChanged(columns), columnInView(columns);
+	for (int i = 0 ; i < columns ; i ++)
+	{
+		int column = firstColumn + (i - firstColumn % columns + columns) %
+			columns;
+		columnChanged[i] = rebindAll || boundColumns[i] != column;
+		boundColumns[i] = column;
+		double columnStart = (double) column * cellWidth;
+		columnInView[i] = columnStart < scrollOffsetX + contentWidth &&
+			columnStart + cellWidth > scrollOffsetX;
+	}
+	for (int i = 0 ; i < rows ; i ++)
+		for (int j = 0 ; j < columns ; j ++)
+		{
+			baseElement &cell = *elements[i * columns + j];
+			if (bindCell && (rowChanged[i] || columnChanged[j]))
+				bindCell(cell, boundRows[i], boundColumns[j], bindData);
+			bool inView = rowInView[i] && columnInView[j];
+			if (cell.get_visibility() != inView)
+				cell.set_visibility(inView);
+		}
+	markSlotsDirty();
+}
 
 
 void baseTableLayout::recalculateSlotBounds(baseElement &element)
 {
-	if (numberOfRows > 0 && numberOfColumns > 0)
+	if (virtualized)
+	{
+		// Cells not bound yet (e.g. while being added) get an empty slot.
+		int slotNumber = element.get_slot_number();
+		int columns = boundColumns.size();
+		int row = -1, column = -1;
+		if (columns > 0 && slotNumber >= 0 &&
+			slotNumber < boundRows.size() * columns)
+		{
+			row = boundRows[slotNumber / columns];
+			column = boundColumns[slotNumber % columns];
+		}
+		if (row < 0 || column < 0)
+		{
+			element.set_slot_position(contentPosX, contentPosY);
+			element.set_slot_size(0, 0);
+		}
+		else
+		{
+			element.set_slot_position(contentPosX + (float) ((double) column *
+				cellWidth - scrollOffsetX), contentPosY + (float) ((double) row *
+				cellHeight - scrollOffsetY));
+			element.set_slot_size(cellWidth, cellHeight);
+		}
+	}
+	else if (numberOfRows > 0 && numberOfColumns > 0)
 	{
 		int slotNumber = element.get_slot_number();
 		float slotsWidth = contentWidth / numberOfColumns;
@@ -1054,6 +4383,64 @@ void baseTableLayout::recalculateSlotBounds(baseElement &element)
 }
 
 
+bool baseTableLayout::calculateSlotRects(float *slotPosX, float *slotPosY,
+	float *slotWidth, float *slotHeight)
+{
+	if (virtualized)
+	{
+		// As below, the first row of cells is calculated and then repeated,
+		// but with the positions of the rows and columns bound to them.
+		int rows = boundRows.size(), columns = boundColumns.size();
+		if (rows * columns != elements.size() ||
+			std::count(boundRows.begin(), boundRows.end(), -1) > 0 ||
+			std::count(boundColumns.begin(), boundColumns.end(), -1) > 0)
+			return false;
+		for (int j = 0 ; j < columns ; j ++)
+			slotPosX[j] = contentPosX + (float) ((double) boundColumns[j] *
+				cellWidth - scrollOffsetX);
+		for (int i = 0 ; i < rows ; i ++)
+		{
+			int first = i * columns;
+			std::copy(slotPosX, slotPosX + columns, slotPosX + first);
+			std::fill(slotPosY + first, slotPosY + first + columns,
+				contentPosY + (float) ((double) boundRows[i] * cellHeight -
+				scrollOffsetY));
+		}
+		std::fill(slotWidth, slotWidth + elements.size(), cellWidth);
+		std::fill(slotHeight, slotHeight + elements.size(), cellHeight);
+		return true;
+	}
+	if (numberOfRows <= 0 || numberOfColumns <= 0)
+		return false;
+	int size = elements.size();
+	float slotsWidth = contentWidth / numberOfColumns;
+	float slotsHeight = contentHeight / numberOfRows;
+
+	// The first row is calculated, and then repeated for every other row
+	// with its own vertical position (so no division is needed per slot).
+	int columns = std::min(numberOfColumns, size);
+	fillSequence(slotPosX, columns, contentPosX, slotsWidth);
+	for (int first = columns ; first < size ; first += columns)
+		std::copy(slotPosX, slotPosX + std::min(columns, size - first),
+			slotPosX + first);
+	for (int row = 0 ; row * columns < size ; row ++)
+	{
+		int first = row * columns;
+		std::fill(slotPosY + first, slotPosY + std::min(first + columns, size),
+			contentPosY + row * slotsHeight);
+	}
+	std::fill(slotWidth, slotWidth + size, slotsWidth);
+	std::fill(slotHeight, slotHeight + size, slotsHeight);
+	return true;
+}
+
+
+bool baseTableLayout::supportsSparseSlots()
+{
+	return false;
+}
+
+
 baseTableLayout::baseTableLayout(int numberOfRows, int numberOfColumns)
 {
 	if (numberOfRows < 0)
@@ -1062,6 +4449,17 @@ baseTableLayout::baseTableLayout(int numberOfRows, int numberOfColumns)
 		numberOfColumns = 0;
 	this->numberOfRows = numberOfRows;
 	this->numberOfColumns = numberOfColumns;
+	virtualized = false;
+	cellWidth = 0;
+	cellHeight = 0;
+	scrollOffsetX = 0;
+	scrollOffsetY = 0;
+	overscan = 0;
+	firstRow = 0;
+	firstColumn = 0;
+	cellPrototype = 0;
+	bindCell = 0;
+	bindData = 0;
 }
 
 
@@ -1070,10 +4468,78 @@ baseTableLayout::~baseTableLayout()
 }
 
 
+bool baseTableLayout::get_virtualization()
+{
+	return virtualized;
+}
+
+
+float baseTableLayout::get_cell_width()
+{
+	return cellWidth;
+}
+
+
+float baseTableLayout::get_cell_height()
+{
+	return cellHeight;
+}
+
+
+double baseTableLayout::get_scroll_offset_x()
+{
+	return scrollOffsetX;
+}
+
+
+double baseTableLayout::get_scroll_offset_y()
+{
+	return scrollOffsetY;
+}
+
+
+double baseTableLayout::get_max_scroll_offset_x()
+{
+	return std::max(0.0, (double) numberOfColumns * cellWidth - contentWidth);
+}
+
+
+double baseTableLayout::get_max_scroll_offset_y()
+{
+	return std::max(0.0, (double) numberOfRows * cellHeight - contentHeight);
+}
+
+
+int baseTableLayout::get_overscan()
+{
+	return overscan;
+}
+
+
+int baseTableLayout::get_first_row()
+{
+	return firstRow;
+}
+
+
+int baseTableLayout::get_first_column()
+{
+	return firstColumn;
+}
+
+
+baseElement* baseTableLayout::get_cell_prototype()
+{
+	return cellPrototype;
+}
+
+
 bool baseTableLayout::is_slot_full(int row, int column)
 {
 	bool b = false;
-	if (row >= 0 && column >= 0 && row < numberOfRows &&
+	if (virtualized)
+		b = get_element(row, column) != 0;
+	else if (row >= 0 && column >= 0 && row < numberOfRows &&
 		column < numberOfColumns)
 		b = baseFreeLayout::is_slot_full(row * numberOfColumns + column);
 	return b;
@@ -1083,7 +4549,15 @@ bool baseTableLayout::is_slot_full(int row, int column)
 baseElement* baseTableLayout::get_element(int row, int column)
 {
 	baseElement* e = 0;
-	if (row >= 0 && column >= 0 && row < numberOfRows &&
+	if (virtualized)
+	{
+		int rows = boundRows.size(), columns = boundColumns.size();
+		if (row >= 0 && column >= 0 && rows * columns == elements.size() &&
+			rows > 0 && columns > 0 && boundRows[row % rows] == row &&
+			boundColumns[column % columns] == column)
+			e = elements[row % rows * columns + column % columns];
+	}
+	else if (row >= 0 && column >= 0 && row < numberOfRows &&
 		column < numberOfColumns)
 		e = baseFreeLayout::get_element(row * numberOfColumns + column);
 	return e;
@@ -1107,8 +4581,10 @@ void baseTableLayout::set_number_of_rows(int numberOfRows)
 	if (numberOfRows >= 0 && numberOfRows != this->numberOfRows)
 	{
 		this->numberOfRows = numberOfRows;
-		elements.resize(numberOfRows * numberOfColumns, 0);
-		recalculateAllSlotBounds();
+		if (virtualized)
+			updateCells(false);
+		else
+			resizeElements(numberOfRows * numberOfColumns);
 	}
 }
 
@@ -1118,8 +4594,10 @@ void baseTableLayout::set_number_of_columns(int numberOfColumns)
 	if (numberOfColumns >= 0 && numberOfColumns != this->numberOfColumns)
 	{
 		this->numberOfColumns = numberOfColumns;
-		elements.resize(numberOfRows * numberOfColumns, 0);
-		recalculateAllSlotBounds();
+		if (virtualized)
+			updateCells(false);
+		else
+			resizeElements(numberOfRows * numberOfColumns);
 	}
 }
 
@@ -1131,17 +4609,124 @@ void baseTableLayout::set_size(int numberOfRows, int numberOfColumns)
 	{
 		this->numberOfRows = numberOfRows;
 		this->numberOfColumns = numberOfColumns;
-		elements.resize(numberOfRows * numberOfColumns, 0);
-		recalculateAllSlotBounds();
+		if (virtualized)
+			updateCells(false);
+		else
+			resizeElements(numberOfRows * numberOfColumns);
+	}
+}
+
+
+void baseTableLayout::set_virtualization(bool virtualized)
+{
+	if (virtualized != this->virtualized)
+	{
+		for (int i = 0 ; i < elements.size() ; i ++)
+			if (elements[i])
+			{
+				baseElement *e = baseFreeLayout::remove_element(i);
+				if (this->virtualized)
+					e->r_delete();
+			}
+		this->virtualized = virtualized;
+		boundRows.clear();
+		boundColumns.clear();
+		if (virtualized)
+			updateCells(true);
+		else
+			resizeElements(numberOfRows * numberOfColumns);
+	}
+}
+
+
+void baseTableLayout::set_cell_size(float cellWidth, float cellHeight)
+{
+	if (cellWidth != this->cellWidth || cellHeight != this->cellHeight)
+	{
+		this->cellWidth = cellWidth;
+		this->cellHeight = cellHeight;
+		if (virtualized)
+			updateCells(false);
+	}
+}
+
+
+void baseTableLayout::set_scroll_offset(double scrollOffsetX,
+	double scrollOffsetY)
+{
+	this->scrollOffsetX = scrollOffsetX;
+	this->scrollOffsetY = scrollOffsetY;
+	if (virtualized)
+		updateCells(false);
+}
+
+
+void baseTableLayout::set_overscan(int overscan)
+{
+	if (overscan >= 0 && overscan != this->overscan)
+	{
+		this->overscan = overscan;
+		if (virtualized)
+			updateCells(false);
 	}
 }
 
 
+void baseTableLayout::set_cell_prototype(baseElement &cellPrototype)
+{
+	if (virtualized)
+		for (int i = 0 ; i < elements.size() ; i ++)
+			if (elements[i])
+				baseFreeLayout::remove_element(i)->r_delete();
+	this->cellPrototype = &cellPrototype;
+	if (virtualized)
+		updateCells(true);
+}
+
+
+void baseTableLayout::set_bind_function(bindFunction bindCell, void *bindData)
+{
+	this->bindCell = bindCell;
+	this->bindData = bindData;
+	if (virtualized)
+		updateCells(true);
+}
+
+
+void baseTableLayout::refresh_cells()
+{
+	if (virtualized)
+		updateCells(true);
+}
+
+
+void baseTableLayout::set_content_size(float contentWidth,
+	float contentHeight)
+{
+	baseFreeLayout::set_content_size(contentWidth, contentHeight);
+	if (virtualized)
+		updateCells(false);
+}
+
+
 void baseTableLayout::copy(baseTableLayout &layout)
 {
 	baseFreeLayout::copy(layout);
 	layout.numberOfRows = numberOfRows;
 	layout.numberOfColumns = numberOfColumns;
+	layout.virtualized = virtualized;
+	layout.cellWidth = cellWidth;
+	layout.cellHeight = cellHeight;
+	layout.scrollOffsetX = scrollOffsetX;
+	layout.scrollOffsetY = scrollOffsetY;
+	layout.overscan = overscan;
+	layout.firstRow = firstRow;
+	layout.firstColumn = firstColumn;
+	layout.boundRows = boundRows;
+	layout.boundColumns = boundColumns;
+	layout.cellPrototype = cellPrototype;
+	layout.bindCell = bindCell;
+	layout.bindData = bindData;
 }
 
 
@@ -1150,64 +4735,409 @@ void baseTableLayout::r_copy(baseTableLayout &layout)
 	baseFreeLayout::r_copy(layout);
 	layout.numberOfRows = numberOfRows;
 	layout.numberOfColumns = numberOfColumns;
+	layout.virtualized = virtualized;
+	layout.cellWidth = cellWidth;
+	layout.cellHeight = cellHeight;
+	layout.scrollOffsetX = scrollOffsetX;
+	layout.scrollOffsetY = scrollOffsetY;
+	layout.overscan = overscan;
+	layout.firstRow = firstRow;
+	layout.firstColumn = firstColumn;
+	layout.boundRows = boundRows;
+	layout.boundColumns = boundColumns;
+	layout.cellPrototype = cellPrototype;
+	layout.bindCell = bindCell;
+	layout.bindData = bindData;
 }
 
 
 void baseTableLayout::add_element(baseElement &element, int row, int column)
 {
-	if (row >= 0 && column >= 0 && row < numberOfRows &&
+	if (!virtualized && row >= 0 && column >= 0 && row < numberOfRows &&
 		column < numberOfColumns)
 		baseFreeLayout::add_element(element, row * numberOfColumns + column);
 }
 
 
+void baseTableLayout::add_elements(const std::vector<baseElement*> &newElements,
+	int row, int column)
+{
+	if (!virtualized && row >= 0 && column >= 0 && row < numberOfRows &&
+		column < numberOfColumns)
+		baseFreeLayout::add_elements(newElements,
+			row * numberOfColumns + column);
+}
+
+
 baseElement* baseTableLayout::remove_element(int row, int column)
 {
 	baseElement *e = 0;
-	if (row >= 0 && column >= 0 && row < numberOfRows &&
+	if (!virtualized && row >= 0 && column >= 0 && row < numberOfRows &&
 		column < numberOfColumns)
 		e = baseFreeLayout::remove_element(row * numberOfColumns + column);
 	return e;
 }
 
 
-bool LAYOUT::position_inside_content_frame(std::map<std::string, void*> &args)
+/* CLASS listLayout */
+
+
+float baseListLayout::getViewportExtent()
+{
+	return std::max(0.0f, horizontal ? contentWidth : contentHeight);
+}
+
+
+baseElement* baseListLayout::createRow()
+{
+	return rowPrototype->r_clone();
+}
+
+
+void baseListLayout::updateRows(bool rebindAll)
 {
-	std::map<std::string, void*>::iterator it1 = args.find("element");
-	std::map<std::string, void*>::iterator it2 = args.find("posX");
-	std::map<std::string, void*>::iterator it3 = args.find("posY");
-	if (it1 != args.end() && it2 != args.end() && it3 != args.end())
+	// The pool covers the content frame, plus a row for an item partly out of
+	// view and 'overscan' rows on each side.
+	int poolSize = 0;
+	if (rowPrototype && itemExtent > 0)
+		poolSize = std::min(itemCount, (int) std::ceil(getViewportExtent() /
+			itemExtent) + 1 + 2 * overscan);
+	scrollOffset = std::max(0.0, std::min(scrollOffset,
+		get_max_scroll_offset()));
+
+	// The slot showing each item depends on the size of the pool, so if it
+	// changes, rows left out are deleted and every row is bound again.
+	if (poolSize != elements.size() || poolSize != boundItems.size())
 	{
-		baseElement *elem = static_cast<baseElement*>(it1->second);
-		float *posX = static_cast<float*>(it2->second);
-		float *posY = static_cast<float*>(it3->second);
-		if (*posX >= elem->get_content_position_x() &&
-			*posX <= elem->get_content_position_x() + elem->get_content_width()
-			&& *posY >= elem->get_content_position_y() && *posY <=
-			elem->get_content_position_y() + elem->get_content_height())
-			// The position (posX, posY) is inside the element's content frame.
-			return true;
+		for (int i = poolSize ; i < elements.size() ; i ++)
+			if (elements[i])
+				baseFreeLayout::remove_element(i)->r_delete();
+		resizeElements(poolSize);
+		boundItems.assign(poolSize, -1);
+	}
+	for (int i = 0 ; i < poolSize ; i ++)
+		if (!elements[i])
+		{
+			boundItems[i] = -1;
+			baseFreeLayout::add_element(*createRow(), i);
+		}
+
+	firstItem = 0;
+	if (poolSize > 0)
+	{
+		firstItem = (int) std::floor(scrollOffset / itemExtent) - overscan;
+		firstItem = std::max(0, std::min(firstItem, itemCount - poolSize));
+	}
+	double viewStart = scrollOffset;
+	double viewEnd = scrollOffset + getViewportExtent();
+	for (int i = 0 ; i < poolSize ; i ++)
+	{
+		// Each slot shows the only item from 'firstItem' on with the slot's
+		// number as remainder.
+		int item = firstItem + (i - firstItem % poolSize + poolSize) % poolSize;
+		baseElement &row = *elements[i];
+		if (rebindAll || boundItems[i] != item)
+		{
+			boundItems[i] = item;
+			if (bindRow)
+				bindRow(row, item, bindData);
+		}
+		double itemStart = (double) item * itemExtent;
+		bool inView = itemStart < viewEnd && itemStart + itemExtent > viewStart;
+		if (row.get_visibility() != inView)
+			row.set_visibility(inView);
+	}
+	markSlotsDirty();
+}
+
+
+void baseListLayout::calculateItemSlot(int item, float &slotPosX,
+	float &slotPosY, float &slotWidth, float &slotHeight)
+{
+	slotPosX = contentPosX;
+	slotPosY = contentPosY;
+	slotWidth = 0;
+	slotHeight = 0;
+	if (item >= 0)
+	{
+		float position = (float) ((double) item * itemExtent - scrollOffset);
+		if (horizontal)
+		{
+			slotPosX += position;
+			slotWidth = itemExtent;
+			slotHeight = contentHeight;
+		}
+		else
+		{
+			slotPosY += position;
+			slotWidth = contentWidth;
+			slotHeight = itemExtent;
+		}
 	}
+}
+
+
+void baseListLayout::recalculateSlotBounds(baseElement &element)
+{
+	int slotNumber = element.get_slot_number();
+	int item = -1;
+	if (slotNumber >= 0 && slotNumber < boundItems.size())
+		item = boundItems[slotNumber];
+	float slotPosX, slotPosY, slotWidth, slotHeight;
+	calculateItemSlot(item, slotPosX, slotPosY, slotWidth, slotHeight);
+	element.set_slot_position(slotPosX, slotPosY);
+	element.set_slot_size(slotWidth, slotHeight);
+}
+
+
+bool baseListLayout::calculateSlotRects(float *slotPosX, float *slotPosY,
+	float *slotWidth, float *slotHeight)
+{
+	for (int i = 0 ; i < elements.size() ; i ++)
+		calculateItemSlot(i < boundItems.size() ? boundItems[i] : -1,
+			slotPosX[i], slotPosY[i], slotWidth[i], slotHeight[i]);
+	return true;
+}
+
+
+bool baseListLayout::supportsSparseSlots()
+{
 	return false;
 }
 
 
-bool LAYOUT::position_inside_slot_frame(std::map<std::string, void*> &args)
+baseListLayout::baseListLayout(bool horizontal, int itemCount,
+	float itemExtent)
+{
+	if (itemCount < 0)
+		itemCount = 0;
+	this->horizontal = horizontal;
+	this->itemCount = itemCount;
+	this->itemExtent = itemExtent;
+	scrollOffset = 0;
+	overscan = 0;
+	firstItem = 0;
+	rowPrototype = 0;
+	bindRow = 0;
+	bindData = 0;
+}
+
+
+baseListLayout::~baseListLayout()
+{
+}
+
+
+bool baseListLayout::is_horizontal()
+{
+	return horizontal;
+}
+
+
+int baseListLayout::get_item_count()
+{
+	return itemCount;
+}
+
+
+float baseListLayout::get_item_extent()
+{
+	return itemExtent;
+}
+
+
+double baseListLayout::get_scroll_offset()
+{
+	return scrollOffset;
+}
+
+
+double baseListLayout::get_max_scroll_offset()
+{
+	return std::max(0.0, (double) itemCount * itemExtent -
+		getViewportExtent());
+}
+
+
+int baseListLayout::get_overscan()
+{
+	return overscan;
+}
+
+
+int baseListLayout::get_first_item()
+{
+	return firstItem;
+}
+
+
+baseElement* baseListLayout::get_row_prototype()
+{
+	return rowPrototype;
+}
+
+
+baseElement* baseListLayout::get_row(int item)
+{
+	int poolSize = boundItems.size();
+	if (item >= 0 && poolSize > 0 && poolSize == elements.size() &&
+		boundItems[item % poolSize] == item)
+		return elements[item % poolSize];
+	return 0;
+}
+
+
+void baseListLayout::set_item_count(int itemCount)
 {
-	std::map<std::string, void*>::iterator it1 = args.find("element");
-	std::map<std::string, void*>::iterator it2 = args.find("posX");
-	std::map<std::string, void*>::iterator it3 = args.find("posY");
-	if (it1 != args.end() && it2 != args.end() && it3 != args.end())
+	if (itemCount >= 0 && itemCount != this->itemCount)
 	{
-		baseElement *elem = static_cast<baseElement*>(it1->second);
-		float *posX = static_cast<float*>(it2->second);
-		float *posY = static_cast<float*>(it3->second);
-		if (*posX >= elem->get_slot_position_x() &&
-			*posX <= elem->get_slot_position_x() + elem->get_slot_width() &&
-			*posY >= elem->get_slot_position_y() &&
-			*posY <= elem->get_slot_position_y() + elem->get_slot_height())
-			// The position (posX, posY) is inside the element's slot frame.
-			return true;
+		this->itemCount = itemCount;
+		updateRows(false);
+	}
+}
+
+
+void baseListLayout::set_item_extent(float itemExtent)
+{
+	if (itemExtent != this->itemExtent)
+	{
+		this->itemExtent = itemExtent;
+		updateRows(false);
+	}
+}
+
+
+void baseListLayout::set_scroll_offset(double scrollOffset)
+{
+	this->scrollOffset = scrollOffset;
+	updateRows(false);
+}
+
+
+void baseListLayout::set_overscan(int overscan)
+{
+	if (overscan >= 0 && overscan != this->overscan)
+	{
+		this->overscan = overscan;
+		updateRows(false);
+	}
+}
+
+
+void baseListLayout::set_row_prototype(baseElement &rowPrototype)
+{
+	for (int i = 0 ; i < elements.size() ; i ++)
+		if (elements[i])
+			baseFreeLayout::remove_element(i)->r_delete();
+	this->rowPrototype = &rowPrototype;
+	updateRows(true);
+}
+
+
+void baseListLayout::set_bind_function(bindFunction bindRow, void *bindData)
+{
+	this->bindRow = bindRow;
+	this->bindData = bindData;
+	updateRows(true);
+}
+
+
+void baseListLayout::refresh_items()
+{
+	updateRows(true);
+}
+
+
+void baseListLayout::set_content_size(float contentWidth, float contentHeight)
+{
+	baseFreeLayout::set_content_size(contentWidth, contentHeight);
+	updateRows(false);
+}
+
+
+void baseListLayout::copy(baseListLayout &layout)
+{
+	baseFreeLayout::copy(layout);
+	layout.horizontal = horizontal;
+	layout.itemCount = itemCount;
+	layout.itemExtent = itemExtent;
+	layout.scrollOffset = scrollOffset;
+	layout.overscan = overscan;
+	layout.firstItem = firstItem;
+	layout.rowPrototype = rowPrototype;
+	layout.bindRow = bindRow;
+	layout.bindData = bindData;
+	layout.boundItems = boundItems;
+}
+
+
+void baseListLayout::r_copy(baseListLayout &layout)
+{
+	baseFreeLayout::r_copy(layout);
+	layout.horizontal = horizontal;
+	layout.itemCount = itemCount;
+	layout.itemExtent = itemExtent;
+	layout.scrollOffset = scrollOffset;
+	layout.overscan = overscan;
+	layout.firstItem = firstItem;
+	layout.rowPrototype = rowPrototype;
+	layout.bindRow = bindRow;
+	layout.bindData = bindData;
+	layout.boundItems = boundItems;
+}
+
+
+bool LAYOUT::position_inside_content_frame(const argumentView &args)
+{
+	baseElement *elem = static_cast<baseElement*>(args.get("element"));
+	float *posX = static_cast<float*>(args.get("posX"));
+	float *posY = static_cast<float*>(args.get("posY"));
+	if (elem && posX && posY)
+	{
+		positionArguments position;
+		position.posX = *posX;
+		position.posY = *posY;
+		return position_inside_content_frame(*elem, position);
+	}
+	return false;
+}
+
+
+bool LAYOUT::position_inside_content_frame(baseElement &element,
+	const positionArguments &args)
+{
+	// The position (posX, posY) has to be inside the element's content frame.
+	return args.posX >= element.get_content_position_x() &&
+		args.posX <= element.get_content_position_x() +
+		element.get_content_width() &&
+		args.posY >= element.get_content_position_y() &&
+		args.posY <= element.get_content_position_y() +
+		element.get_content_height();
+}
+
+
+bool LAYOUT::position_inside_slot_frame(const argumentView &args)
+{
+	baseElement *elem = static_cast<baseElement*>(args.get("element"));
+	float *posX = static_cast<float*>(args.get("posX"));
+	float *posY = static_cast<float*>(args.get("posY"));
+	if (elem && posX && posY)
+	{
+		positionArguments position;
+		position.posX = *posX;
+		position.posY = *posY;
+		return position_inside_slot_frame(*elem, position);
 	}
 	return false;
+}
+
+
+bool LAYOUT::position_inside_slot_frame(baseElement &element,
+	const positionArguments &args)
+{
+	// The position (posX, posY) has to be inside the element's slot frame.
+	return args.posX >= element.get_slot_position_x() &&
+		args.posX <= element.get_slot_position_x() + element.get_slot_width() &&
+		args.posY >= element.get_slot_position_y() &&
+		args.posY <= element.get_slot_position_y() + element.get_slot_height();
 }
\ No newline at end of file
@@ -20,6 +20,19 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+// 'std::string_view' overloads are only available when compiling as C++17 or
+// later.
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define LAYOUT_STRING_VIEW
+#include <string_view>
+#endif
 
 
 namespace LAYOUT
@@ -75,10 +88,125 @@ namespace LAYOUT
 
 
 	/*
-	- Incomplete declarations. Needed in class 'baseElement' (declared first).
+	- Possible orders in which a layout iterator visits the elements in a
+	layout.
+	*/
+	enum TRAVERSAL
+	{
+		/*
+		- Each layout is visited before the elements inside it, which are
+		visited in slot order.
+		*/
+		preorder,
+
+		/*
+		- Each layout is visited after the elements inside it, which are
+		visited in slot order.
+		*/
+		postorder,
+
+		/*
+		- Each layout is visited before the elements inside it, which are
+		visited in draw order (from greater to lower depth). Only visible
+		elements are visited.
+		*/
+		depthorder
+	};
+
+
+	/*
+	- Incomplete declarations. Needed in classes 'nameIndex' and 'baseElement'
+	(declared first).
 	*/
+	class baseElement;
 	class baseFreeLayout;
 	class event;
+	class geometryStore;
+	class elementHandler;
+	class layoutVisitor;
+	class threadPool;
+
+
+	/*
+	- Index of elements by name, used by layouts and handlers to find elements
+	without visiting them all.
+	- Elements are stored under a hash of their name, so that names can be
+	looked up from any sequence of characters without allocating strings.
+	Different names may share a hash, so the names of the elements found must
+	still be compared.
+	- Elements with an empty name aren't indexed.
+	*/
+	class nameIndex
+	{
+	public:
+
+		/*
+		- Type of the lists of elements whose names share a hash.
+		*/
+		typedef std::vector<baseElement*> entryList;
+
+		/*
+		- Returns the hash of a name, given its characters and length.
+		*/
+		static std::size_t hash(const char *name, std::size_t length);
+
+		/*
+		- Returns 'true' if the element's name is the given one.
+		*/
+		static bool has_name(baseElement &element, const char *name,
+			std::size_t length);
+
+		/*
+		- Returns the number of elements in the index.
+		*/
+		int get_size();
+
+		/*
+		- Returns the elements whose name has the given hash, in no particular
+		order.
+		*/
+		const entryList& find(std::size_t nameHash);
+
+		/*
+		- Adds an element to the index under its current name.
+		*/
+		void add(baseElement &element);
+
+		/*
+		- Adds every element in another index to this one.
+		*/
+		void add(nameIndex &index);
+
+		/*
+		- Removes an element from the index, if it's in it under its current
+		name.
+		- It takes constant time, however many elements share the name.
+		*/
+		void remove(baseElement &element);
+
+		/*
+		- Removes every element from the index.
+		*/
+		void clear();
+
+	protected:
+
+		/*
+		- Elements in the index, under the hash of their name.
+		*/
+		std::unordered_map<std::size_t, entryList> entries;
+
+		/*
+		- Position of every element in its list in 'entries', so that it's
+		removed without searching the list.
+		*/
+		std::unordered_map<baseElement*, int> positions;
+
+		/*
+		- Empty list, returned by 'find' when no element has the hash.
+		*/
+		static const entryList noEntries;
+	};
 
 
 	/*
@@ -95,16 +223,125 @@ namespace LAYOUT
 	protected:
 
 		/*
-		- Keeps count of the number of instanced elements, and is used to
-		provide them with unique ids upon initialisation.
+		- Ids are made of an index (their lowest 'idIndexBits' bits) and the
+		generation of that index when the id was given (the 32 bits above).
+		Indices of destroyed elements are reused with the next generation, so
+		their old ids don't match the new elements.
+		- Up to 2^22 elements can exist at once, and an index can be reused
+		2^32 times before its ids repeat.
+		*/
+		static const int idIndexBits = 22;
+		static const int idIndexMask = (1 << idIndexBits) - 1;
+
+		/*
+		- Current generation of every id index. It wraps around after 2^32
+		reuses.
 		*/
-		static int idGenerator;
+		static std::vector<unsigned int> idGenerations;
+
+		/*
+		- Id indices not in use by any element.
+		*/
+		static std::vector<int> freeIdIndices;
+
+		/*
+		- The id of the element using an index (-1 if it's free), and the
+		element.
+		- Both are atomic, so that elements are found by id without locking
+		'idMutex' (see 'findById').
+		*/
+		struct idSlot
+		{
+			std::atomic<long long> id;
+			std::atomic<baseElement*> element;
+		};
+
+		/*
+		- Slots of every id index, in blocks of 'idBlockSize' indices.
+		- It's shared by all handlers, which find their elements by id through
+		it instead of keeping a table of their own.
+		- Blocks are allocated when their first index is given, and never moved
+		or freed, so they can be read while others are added.
+		*/
+		static const int idBlockBits = 12;
+		static const int idBlockSize = 1 << idBlockBits;
+		static std::atomic<idSlot*> idBlocks[(idIndexMask >> idBlockBits) + 1];
+
+		/*
+		- Guards 'idGenerations', 'freeIdIndices' and the writing of
+		'idBlocks', so that elements can be created and destroyed in several
+		threads at once.
+		*/
+		static std::mutex idMutex;
+
+		/*
+		- Gives the element a new id, reusing the index of a destroyed element
+		if there's any.
+		- Throws 'std::length_error' if all 2^22 indices are in use, as their
+		ids would no longer be unique.
+		*/
+		static void acquireId(baseElement &element);
+
+		/*
+		- Frees the index of an id, so it can be reused.
+		*/
+		static void releaseId(long long id);
+
+		/*
+		- Returns a pointer to the existing element with the given id, or 0 if
+		there's none.
+		- It takes no lock, so elements are found while others are created or
+		destroyed in other threads.
+		*/
+		static baseElement* findById(long long elementId);
+
+		/*
+		- Number of layouts with an open update scope.
+		- While it's 0, elements don't need to look for suspended layouts
+		containing them.
+		- It's atomic, since elements read it from worker and render threads
+		while scopes are opened and closed.
+		*/
+		static std::atomic<int> openUpdateScopes;
+
+		/*
+		- Number of parallel layout updates running (see
+		'baseFreeLayout::update_layout').
+		- While it's not 0, elements lock 'indexMutex' before updating their
+		geometry store and the spatial indexes of their handlers, which
+		elements updated in other threads may share.
+		*/
+		static std::atomic<int> parallelUpdates;
+
+		/*
+		- Guards geometry stores and the spatial indexes of handlers during
+		parallel layout updates.
+		*/
+		static std::mutex indexMutex;
+
+		/*
+		- The element as a layout, or 0 if it isn't one.
+		- Set by the constructor of 'baseFreeLayout', so that layouts can be
+		told apart without 'dynamic_cast'.
+		*/
+		baseFreeLayout *thisLayout;
+
+		/*
+		- The object extending the element in a library built on this one (such
+		as 'element' in 'SFMLLayout.hpp'), or 0 if there's none.
+		- Set by the constructor of that object, so that the library can find
+		it without 'dynamic_cast'.
+		*/
+		void *extension;
 
 		/*
 		- Number which uniquely identifies the element.
 		- It's automatically assigned and can't be modified.
+		- Ids of destroyed elements are never given to other elements (see
+		'idIndexBits'), and their index can be used to store elements in
+		vectors (see 'elementHandler').
 		*/
-		int id;
+		long long id;
 
 		/*
 		- The name of the element.
@@ -112,6 +349,23 @@ namespace LAYOUT
 		*/
 		std::string name;
 
+		/*
+		- Hash of the attribute 'name' (see 'nameIndex').
+		*/
+		std::size_t nameHash;
+
+		/*
+		- Handlers containing the element, which need to know when its name
+		changes.
+		*/
+		std::vector<elementHandler*> handlers;
+
+		/*
+		- Position of the element in the attribute 'elements' of every handler
+		in 'handlers', in the same order.
+		*/
+		std::vector<int> handlerPositions;
+
 		/*
 		- Pointer to the parent layout.
 		- Used in order to prevent the element from being added to muliple
@@ -202,12 +456,108 @@ namespace LAYOUT
 		*/
 		bool contentVisible;
 
+		/*
+		- 'true' if the element, or any element inside it, has pending layout
+		changes that will be applied on the next call to 'update_layout'.
+		- Whenever an element is marked, so are all the layouts containing it.
+		*/
+		bool layoutDirty;
+
+		/*
+		- 'true' if the content has to be aligned on the next call to
+		'update_layout', because it was aligned while updates were suspended.
+		*/
+		bool alignmentDirty;
+
+		/*
+		- 'true' while 'applySlotBounds' sets the slot, so that the default
+		'set_slot_position' and 'set_slot_size' leave the content alone (it's
+		placed once afterwards).
+		*/
+		bool alignmentDeferred;
+
+		/*
+		- Geometry store keeping a copy of the element's position, size and
+		alignment attributes, or null if there's none.
+		*/
+		geometryStore *geometry;
+
+		/*
+		- Position of the element in the arrays of its geometry store, or -1 if
+		it isn't in one.
+		*/
+		int geometryIndex;
+
+		/*
+		- Marks the element and every layout containing it as having pending
+		layout changes.
+		*/
+		void markLayoutDirty();
+
+		/*
+		- 'true' if the element has been moved or resized since the subtree
+		bounds of the layout containing it (see 'baseFreeLayout') were last
+		calculated, or if it's a layout and its own need to be recalculated.
+		- Whenever an element is marked, so are all the layouts containing it.
+		*/
+		bool boundsDirty;
+
+		/*
+		- Marks the subtree bounds of the element and of every layout
+		containing it for recalculation.
+		*/
+		void markBoundsDirty();
+
+		/*
+		- Marks the element as changed in its geometry store (if any), updates the spatial index of the handlers
+		containing it and marks its subtree bounds for recalculation.
+		- MUST be called whenever any of those attributes is modified.
+		*/
+		void storeGeometry();
+
+		/*
+		- Sets the slot's position and size, and the content's position (which
+		must be the one 'align' would give the content in that slot).
+		- Used by layouts to apply slots calculated in bulk. Has the same effect
+		as setting the slot and aligning the content: the slot is set through
+		'set_slot_position' and 'set_slot_size', so redefinitions are still
+		called, and the content is aligned as usual if they change the slot.
+		*/
+		void applySlotBounds(float slotPosX, float slotPosY, float slotWidth,
+			float slotHeight, float contentPosX, float contentPosY);
+
+		/*
+		- Recalculates the slots of the layouts containing the element, if
+		any of them has pending changes (see 'update_layout'), unless updates
+		are suspended.
+		- Called before alignment changes, so that pending slots are applied
+		with the alignment the element had when they were changed, and before
+		the element's position or size is read, so that it's never stale.
+		*/
+		void updatePendingSlots();
+
+		/*
+		- Sets both alignment attributes, without applying pending slots first
+		(see 'set_alignment').
+		- Invalid values leave alignment on that axis unchanged.
+		*/
+		void assignAlignment(ALIGNMENT alignmentX, ALIGNMENT alignmentY);
+
 		/*
 		- Draws the element's content.
 		- MUST be defined in instantiable derived classes.
 		*/
 		virtual void drawContent() = 0;
 
+		/*
+		- Draws whatever the element shows around its content (nothing by
+		default).
+		- Returns 'false' if the element can't be drawn at all, in which case
+		its content isn't drawn either.
+		- Can be redefined in derived classes.
+		*/
+		virtual bool drawFrame();
+
 		/*
 		- Map of events associated to the element, each identified by a string.
 		*/
@@ -235,12 +585,28 @@ namespace LAYOUT
 		/*
 		- Returns the value of the attribute 'id'.
 		*/
-		int get_id();
+		long long get_id();
+
+		/*
+		- Returns 'true' if the element is a layout.
+		*/
+		bool is_layout();
+
+		/*
+		- Returns a pointer to the element as a layout, or 0 if it isn't one.
+		- Same as 'dynamic_cast<baseFreeLayout*>', but faster.
+		*/
+		baseFreeLayout* as_layout();
+
+		/*
+		- Returns the value of the attribute 'extension'.
+		*/
+		void* get_extension();
 
 		/*
 		- Returns the value of the attribute 'name'.
 		*/
-		std::string get_name();
+		const std::string& get_name();
 
 		/*
 		- Returns the value of the attribute 'parentLayout'.
@@ -251,44 +617,62 @@ namespace LAYOUT
 		- Returns the value of the attribute 'slotNumber'.
 		*/
 		int get_slot_number();
+
+		/*
+		- Returns the value of the attribute 'geometry'.
+		*/
+		geometryStore* get_geometry_store();
+
+		/*
+		- Returns the value of the attribute 'geometryIndex'.
+		*/
+		int get_geometry_index();
 		
 		/*
 		- Returns the value of the attribute 'contentPosX'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_content_position_x();
 		
 		/*
 		- Returns the value of the attribute 'contentPosY'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_content_position_y();
 		
 		/*
 		- Returns the value of the attribute 'contentWidth'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_content_width();
 		
 		/*
 		- Returns the value of the attribute 'contentHeight'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_content_height();
 		
 		/*
 		- Returns the value of the attribute 'slotPosX'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_slot_position_x();
 		
 		/*
 		- Returns the value of the attribute 'slotPosY'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_slot_position_y();
 		
 		/*
 		- Returns the value of the attribute 'slotWidth'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_slot_width();
 		
 		/*
 		- Returns the value of the attribute 'slotHeight'.
+		- Pending slot changes are applied first (see 'updatePendingSlots').
 		*/
 		float get_slot_height();
 
@@ -319,6 +703,8 @@ namespace LAYOUT
 
 		/*
 		- Returns a reference to the whole map of events for the element.
+		- Handlers aren't aware of changes made to the map through it. Events
+		should be changed with 'set_events', 'add_event' and 'remove_event'.
 		*/
 		std::map<std::string, event*>& get_events();
 
@@ -330,8 +716,22 @@ namespace LAYOUT
 
 		/*
 		- Sets the attribute 'name'.
+		- The element is indexed under its new name in the layouts and handlers
+		containing it.
+		*/
+		void set_name(const std::string &name);
+
+		/*
+		- Adds the element to the given geometry store, removing it from its
+		previous one (if any).
 		*/
-		void set_name(std::string name);
+		void set_geometry_store(geometryStore &store);
+
+		/*
+		- Calls 'set_geometry_store(store)'.
+		- Can be redefined in derived classes.
+		*/
+		virtual void r_set_geometry_store(geometryStore &store);
 
 		/*
 		- Sets the attributes 'contentPosX' and 'contentPosY'.
@@ -348,14 +748,16 @@ namespace LAYOUT
 
 		/*
 		- Sets the attributes 'slotPosX' and 'slotPosY'.
-		- Aligns the content inside the slot.
+		- Aligns the content inside the slot (unless a layout is applying the
+		slot in bulk, which aligns it afterwards).
 		- Can be redefined in derived classes.
 		*/
 		virtual void set_slot_position(float slotPosX, float slotPosY);
 
 		/*
 		- Sets the attributes 'slotWidth' and 'slotHeight'.
-		- Aligns the content inside the slot.
+		- Aligns the content inside the slot (unless a layout is applying the
+		slot in bulk, which aligns it afterwards).
 		- Can be redefined in derived classes.
 		*/
 		virtual void set_slot_size(float slotWidth, float slotHeight);
@@ -385,24 +787,32 @@ namespace LAYOUT
 		/*
 		- Sets the attribute 'alignmentX'.
 		- Invalid values leave it unchanged.
+		- Pending slot changes of the layouts containing the element are
+		applied first, with the previous alignment.
 		*/
 		void set_alignment_x(ALIGNMENT alignmentX);
 
 		/*
 		- Sets the attribute 'alignmentY'.
 		- Invalid values leave it unchanged.
+		- Pending slot changes of the layouts containing the element are
+		applied first, with the previous alignment.
 		*/
 		void set_alignment_y(ALIGNMENT alignmentY);
 
 		/*
 		- Sets both alignment attributes.
 		- Invalid values leave alignment on that axis unchanged.
+		- Pending slot changes of the layouts containing the element are
+		applied first, with the previous alignment.
 		*/
 		void set_alignment(ALIGNMENT alignmentX, ALIGNMENT alignmentY);
 
 		/*
 		- Sets the position of the content inside the slot according to
 		the current value of 'alignmentX' and 'alignmentY'.
+		- If the element is inside a layout with an open update scope, this is
+		postponed until the scope is closed.
 		*/
 		void align();
 
@@ -424,13 +834,32 @@ namespace LAYOUT
 		*/
 		virtual void r_align(ALIGNMENT alignmentX, ALIGNMENT alignmentY);
 
+		/*
+		- Returns 'true' if the element is inside a layout with an open update
+		scope (see 'baseFreeLayout::begin_update').
+		- Can be redefined in derived classes.
+		*/
+		virtual bool is_updating();
+
+		/*
+		- Applies the pending layout changes of the element (if any).
+		- Does nothing while the element is inside a layout with an open update
+		scope.
+		- Can be redefined in derived classes.
+		*/
+		virtual void update_layout();
+
 		/*
 		- Sets the attribute 'depth'.
+		- If the value changes, the drawing order of the parent layout is
+		marked for sorting.
 		*/
 		void set_depth(int depth);
 
 		/*
 		- Sets the attribute 'visible'.
+		- If the value changes, the drawing order of the parent layout is
+		marked for sorting.
 		*/
 		void set_visibility(bool visible);
 
@@ -441,17 +870,20 @@ namespace LAYOUT
 
 		/*
 		- Sets the attribute 'events' as a copy of the given map.
+		- The handlers containing the element are updated.
 		*/
 		void set_events(std::map<std::string, event*> &events);
 
 		/*
 		- Adds an event under the given name.
 		- If there is already one, it is overwritten.
+		- The handlers containing the element are updated.
 		*/
 		void add_event(std::string eventName, event &e);
 
 		/*
 		- Removes from the element the event under the given name (if any).
+		- The handlers containing the element are updated.
 		*/
 		void remove_event(std::string eventName);
 
@@ -486,7 +918,8 @@ namespace LAYOUT
 		virtual void r_delete();
 
 		/*
-		- Calls 'drawContent' if the content is set visible.
+		- Applies any pending layout changes, then calls 'drawFrame', and
+		'drawContent' if the content is set visible.
 		- Can be redefined in derived classes.
 		*/
 		virtual void draw();
@@ -497,451 +930,2995 @@ namespace LAYOUT
 		'slotNumber'.
 		*/
 		friend class baseFreeLayout;
+
+		/*
+		- Geometry stores read the element's attributes and keep its attributes
+		'geometry' and 'geometryIndex' up to date.
+		*/
+		friend class geometryStore;
+
+		/*
+		- Name indices read the attributes 'name' and 'nameHash'.
+		*/
+		friend class nameIndex;
+
+		/*
+		- Handlers keep the attribute 'handlers' up to date.
+		*/
+		friend class elementHandler;
 	};
 
 
 	/*
-	- Groups elements together.
-	- Allows storage, retrieval, and simultaneous event handling.
+	- Keeps the position, size and alignment attributes of many elements in
+	contiguous arrays (one per attribute), indexed by a dense element index.
+	- Elements only mark themselves as changed in the store when their
+	attributes change, and the arrays are copied from the changed elements
+	the next time they're read, so setters don't write everything twice.
+	Passes over large trees can then read the arrays sequentially instead of
+	visiting every element. Element handlers whose elements share
+	a store find elements by position this way (see
+	'elementHandler::find_elements_at').
+	- Removing an element moves the last one into its position, so indices are
+	only stable until an element is removed.
+	- Using a store is optional. Destroying it doesn't destroy its elements.
 	*/
-	class elementHandler
+	class geometryStore
 	{
 	protected:
 
 		/*
-		- Map storing the elements, with their id as the key.
-		- There can be no repeated elements.
+		- Elements in the store, by index.
 		*/
-		std::map<int, baseElement*> idMap;
-
-	public:
+		std::vector<baseElement*> elements;
 
 		/*
-		- Default constructor.
+		- Attribute 'contentPosX' of every element in the store, by index.
 		*/
-		elementHandler();
+		std::vector<float> contentPosX;
 
 		/*
-		- Copy constructor.
-		- The new handler contains pointers to the same elements as the source.
+		- Attribute 'contentPosY' of every element in the store, by index.
 		*/
-		elementHandler(elementHandler &handler);
+		std::vector<float> contentPosY;
 
 		/*
-		- Default destructor.
+		- Attribute 'contentWidth' of every element in the store, by index.
 		*/
-		~elementHandler();
+		std::vector<float> contentWidth;
 
 		/*
-		- Returns a copy of 'idMap'.
+		- Attribute 'contentHeight' of every element in the store, by index.
 		*/
-		std::map<int, baseElement*> get_map();
+		std::vector<float> contentHeight;
 
 		/*
-		- Makes the received handler into a copy of the current handler.
-		- The received one contains pointers to the same elements as the source.
+		- Attribute 'slotPosX' of every element in the store, by index.
 		*/
-		void copy(elementHandler &handler);
+		std::vector<float> slotPosX;
 
 		/*
-		- Returns a pointer to the element in the handler with the given id.
-		- If no element with that id is found, the return value is 0.
+		- Attribute 'slotPosY' of every element in the store, by index.
 		*/
-		baseElement* find_element(int elementId);
+		std::vector<float> slotPosY;
 
 		/*
-		- Returns a pointer to the element in the handler with the given name.
-		- If no element with that name is found, the return value is 0.
+		- Attribute 'slotWidth' of every element in the store, by index.
 		*/
-		baseElement* find_element(std::string elementName);
+		std::vector<float> slotWidth;
 
 		/*
-		- Adds the given element to the handler.
+		- Attribute 'slotHeight' of every element in the store, by index.
 		*/
-		void add_element(baseElement &element);
+		std::vector<float> slotHeight;
 
 		/*
-		- Recursively adds to the handler the layout and every element in it.
+		- Attribute 'alignmentX' of every element in the store, by index.
 		*/
-		void r_add_element(baseElement &element);
+		std::vector<ALIGNMENT> alignmentX;
 
 		/*
-		- Removes from the handler the given element (if present).
+		- Attribute 'alignmentY' of every element in the store, by index.
 		*/
-		void remove_element(baseElement &element);
+		std::vector<ALIGNMENT> alignmentY;
 
 		/*
-		- Removes from the handler the given element (if present).
-		- If the element is a layout, every element inside it is also
-		recursively removed.
+		- Indices of the elements that have changed since the last call to
+		'clear_changes', in the order they first changed.
 		*/
-		void r_remove_element(baseElement &element);
+		std::vector<int> changedIndices;
 
 		/*
-		- For all elements in the handler, activates the events identified by a
-		given string.
-		- New maps of arguments for condition and effect methods can be
-		provided, in which case they will be added to the default maps.
-		- If an argument is provided under the same string that an existing
-		default argument, the new one overwrites the default one.
+		- Whether each index is already in 'changedIndices' (1), and also has
+		attributes not copied to the arrays yet (2), by index.
 		*/
-		void activate_events(std::string eventName,
-			std::map<std::string, void*> &conditionArgs =
-			std::map<std::string, void*>::map<std::string, void*>(),
-			std::map<std::string, void*> &effectArgs =
-			std::map<std::string, void*>::map<std::string, void*>());
-	};
-	
-
-	/*
-	- An event. An association of a condition and an effect.
-	*/
-	class event
-	{
-	protected:
+		std::vector<char> changedFlags;
 
 		/*
-		- Type redefinitions for pointers to functions.
-		- These redefinitions make it easier to manage the types while using
-		them in method arguments or return values.
+		- Whether any index in 'changedIndices' has attributes not copied to
+		the arrays yet.
 		*/
-		typedef bool (*eventConditionType)(std::map<std::string, void*>&);
-		typedef void (*eventEffectType)(std::map<std::string, void*>&);
+		bool stale;
 
 		/*
-		- A method implementing the condition to decide if the event effect
-		should be triggered.
-		- Without a condition, the effect (if any) will always be triggered
-		upon activation.
+		- Adds an index to 'changedIndices', unless it's already there.
 		*/
-		eventConditionType eventCondition;
-		
+		void markChanged(int index);
+
 		/*
-		- A method implementing the effect of the event.
-		- Without an effect, nothing will be triggered upon activation.
+		- Marks the index of an element in the store as changed, and its
+		attributes as not copied to the arrays yet.
 		*/
-		eventEffectType eventEffect;
+		void store(baseElement &element);
 
 		/*
-		- The set of arguments passed on by default to the condition function.
+		- Copies to the arrays the attributes of every element marked by
+		'store' since the last call.
 		*/
-		std::map<std::string, void*> defaultConditionArgs;
+		void refresh();
+
+	public:
 
 		/*
-		- The set of arguments passed on by default to the effect function.
+		- Default constructor.
 		*/
-		std::map<std::string, void*> defaultEffectArgs;
+		geometryStore();
 
-	public:
+		/*
+		- Default destructor.
+		- Elements in the store are removed from it, but not destroyed.
+		*/
+		~geometryStore();
 
 		/*
-		- Default constructor.
+		- Returns the number of elements in the store.
 		*/
-		event(eventConditionType eventCondition = 0,
-			eventEffectType eventEffect = 0,
-			std::map<std::string, void*> &defaultConditionArgs =
-			std::map<std::string, void*>::map<std::string, void*>(),
-			std::map<std::string, void*> &defaultEffectArgs =
-			std::map<std::string, void*>::map<std::string, void*>());
+		int get_size();
 
 		/*
-		- Returns a pointer to the event condition function.
+		- Returns a pointer to the element with the given index, or null if
+		the index is out of range.
 		*/
-		eventConditionType get_event_condition();
+		baseElement* get_element(int index);
 
 		/*
-		- Returns a pointer to the event effect function..
+		- Returns the values of the attribute 'contentPosX', by index.
 		*/
-		eventEffectType get_event_effect();
+		const std::vector<float>& get_content_position_x();
 
 		/*
-		- Returns a reference to the attribute 'defaultConditionArgs'.
+		- Returns the values of the attribute 'contentPosY', by index.
 		*/
-		std::map<std::string, void*>& get_default_condition_args();
+		const std::vector<float>& get_content_position_y();
 
 		/*
-		- Returns a reference to the attribute 'defaultEffectArgs'.
+		- Returns the values of the attribute 'contentWidth', by index.
 		*/
-		std::map<std::string, void*>& get_default_effect_args();
+		const std::vector<float>& get_content_width();
 
 		/*
-		- Sets the pointer to the event condition function.
+		- Returns the values of the attribute 'contentHeight', by index.
 		*/
-		void set_event_condition(eventConditionType eventCondition);
+		const std::vector<float>& get_content_height();
 
 		/*
-		- Sets the pointer to the event effect function.
+		- Returns the values of the attribute 'slotPosX', by index.
 		*/
-		void set_event_effect(eventEffectType eventEffect);
+		const std::vector<float>& get_slot_position_x();
 
 		/*
-		- Sets the attribute 'defaultConditionArgs' as a copy of the given map.
+		- Returns the values of the attribute 'slotPosY', by index.
 		*/
-		void set_default_condition_args(
-			std::map<std::string, void*> &defaultConditionArgs);
+		const std::vector<float>& get_slot_position_y();
 
 		/*
-		- Sets the attribute 'defaultEffectArgs' as a copy of the given map.
+		- Returns the values of the attribute 'slotWidth', by index.
 		*/
-		void set_default_effect_args(
-			std::map<std::string, void*> &defaultEffectArgs);
+		const std::vector<float>& get_slot_width();
 
 		/*
-		- Adds an argument to the default condition map.
-		- If there is already an argument with that name, it's overwritten.
+		- Returns the values of the attribute 'slotHeight', by index.
 		*/
-		void add_default_condition_argument(std::string argName,
-			void *argValue);
+		const std::vector<float>& get_slot_height();
 
 		/*
-		- Adds an argument to the default effect map.
-		- If there is already an argument with that name, it's overwritten.
+		- Returns the values of the attribute 'alignmentX', by index.
 		*/
-		void add_default_effect_argument(std::string argName, void *argValue);
+		const std::vector<ALIGNMENT>& get_alignment_x();
 
 		/*
-		- If it exists, removes the argument with the given name from the
-		default condition map.
+		- Returns the values of the attribute 'alignmentY', by index.
 		*/
-		void remove_default_condition_argument(std::string argName);
+		const std::vector<ALIGNMENT>& get_alignment_y();
 
 		/*
-		- If it exists, removes the argument with the given name from the
-		default effect map.
+		- Adds an element to the store, removing it from its previous store (if
+		any). It's given the last index.
 		*/
-		void remove_default_effect_argument(std::string argName);
+		void add_element(baseElement &element);
 
 		/*
-		- Checks that the codition is fulfilled, and if so activates the effect.
-		- The method receives up to two argument maps, to be passed on to the
-		condition and effect methods respectively.
+		- Removes an element from the store (if it's in it).
+		- The last element in the store takes its index.
 		*/
-		void activate(std::map<std::string, void*> &conditionArgs =
-			std::map<std::string, void*>::map<std::string, void*>(),
-			std::map<std::string, void*> &effectArgs =
-			std::map<std::string, void*>::map<std::string, void*>());
+		void remove_element(baseElement &element);
+
+		/*
+		- Stores in the given vector the indices of the elements in the store
+		whose slot or content frame contains the given position, in increasing
+		order.
+		- Only the arrays are read, one index after another.
+		*/
+		void find_elements_at(float posX, float posY, std::vector<int> &found);
+
+		/*
+		- Marks an element in the store as changed even though its geometry
+		hasn't (e.g. its visibility or appearance has).
+		*/
+		void mark_changed(baseElement &element);
+
+		/*
+		- Returns the indices of the elements whose geometry (or anything
+		marked with 'mark_changed') has changed since the last call to
+		'clear_changes'. Each index appears once.
+		- Indices may be out of range, if elements have been removed since.
+		- Lets a single consumer (e.g. a snapshot buffer, see 'SFMLLayout.hpp')
+		copy only what has changed.
+		*/
+		const std::vector<int>& get_changes();
+
+		/*
+		- Forgets the changes returned by 'get_changes'.
+		*/
+		void clear_changes();
+
+		/*
+		- Method 'storeGeometry' from 'baseElement' needs to call 'store'.
+		*/
+		friend class baseElement;
 	};
 
-	
+
 	/*
-	- A layout (a series of slots where elements can be allocated).
-	- The position and size of slots in a free layout are not restricted by
-	the bounds of the layout content. Slots can overlap.
-	- By default, newly added elements keep their content bounds and alignment.
-	- This class shouldn't be instanced, but serve as a base for other classes.
+	- A position. Condition arguments for typed events (see 'typedEvent') using
+	the stock conditions 'position_inside_content_frame' and
+	'position_inside_slot_frame'.
 	*/
-	class baseFreeLayout : public virtual baseElement
+	struct positionArguments
+	{
+		/*
+		- The target position on the X axis.
+		*/
+		float posX;
+
+		/*
+		- The target position on the Y axis.
+		*/
+		float posY;
+	};
+
+
+	/*
+	- A set of bits, one for each slot of a layout, telling which slots are
+	full.
+	- Searches go through whole words of 64 slots at a time, so empty (or full)
+	runs of slots are skipped without visiting them one by one.
+	*/
+	class slotBitset
 	{
 	protected:
-		
+
 		/*
-		- Vector storing the pointers to all the elements inside the layout.
-		- Its size is the size of the layout (number of available slots).
+		- Bits of the set, 64 in each word. Bits past the size are always
+		cleared.
 		*/
-		std::vector<baseElement*> elements;
+		std::vector<unsigned long long> words;
 
 		/*
-		- Number of elements inside the layout (or number of full slots).
-		- Always less than or equal to the size of the layout.
+		- Number of bits in the set.
 		*/
-		int elementCount;
-		
+		int size;
+
+	public:
+
 		/*
-		- Position of the lowest empty slot in the 'elements' vector.
-		- Technically, the first null position in 'elements'.
-		- If a layout has no elements, its value is 0.
+		- Default constructor.
+		- Creates an empty set.
 		*/
-		int lowestEmptySlot;
-		
+		slotBitset();
+
 		/*
-		- Position of the highest full slot in the 'elements' vector.
-		- Technically, the last non-null position in 'elements'.
-		- If a layout has no elements, its value is -1.
+		- Returns the number of bits in the set.
 		*/
-		int highestFullSlot;
+		int get_size() const;
 
 		/*
-		- Alignment on X of newly added elements will be changed to this value.
-		- Valid values are 'none', 'left', 'right', 'center', and 'keep'.
-		- 'keep' causes newly added elements to retain their original values.
+		- Returns 'true' if the given bit is set.
 		*/
-		ALIGNMENT defaultAlignmentX;
+		bool test(int bit) const;
 
 		/*
-		- Alignment on Y of newly added elements will be changed to this value.
-		- Valid values are 'none', 'top', 'bottom', 'center', and 'keep'.
-		- 'keep' causes newly added elements to retain their original values.
+		- Returns the lowest set bit from the given one on, or the size of the
+		set if there's none.
 		*/
-		ALIGNMENT defaultAlignmentY;
-		
+		int find_next_set(int bit) const;
+
 		/*
-		- If 'true', adding elements in slots greater than the layout's size
-		will cause the layout to be resized to fit them.
-		- If 'false', those elements cannot be added.
+		- Returns the lowest cleared bit from the given one on, or the size of
+		the set if there's none.
 		*/
-		bool elastic;
+		int find_next_cleared(int bit) const;
 
 		/*
-		- Recalculates the position and size of an element's slot given its
-		position inside the 'elements' vector.
-		- In this case (free layout) it does nothing.
-		- Can be redefined in derived classes.
+		- Returns the highest set bit up to the given one, or -1 if there's
+		none.
 		*/
-		virtual void recalculateSlotBounds(baseElement &element);
+		int find_previous_set(int bit) const;
 
 		/*
-		- Calls 'recalculateSlotBounds' for every element in the layout.
+		- Returns the highest set bit, or -1 if there's none.
 		*/
-		void recalculateAllSlotBounds();
+		int find_last_set() const;
 
 		/*
-		- Calls the 'draw' method of every element in the layout.
-		- Non-visible elements are excluded.
-		- Elements are drawn in order of greater to lesser depth.
+		- Returns the number of set bits from 'first' up to (not including)
+		'last'.
 		*/
-		void drawContent();
+		int count(int first, int last) const;
+
+		/*
+		- Changes the number of bits in the set. New bits are cleared.
+		*/
+		void resize(int size);
+
+		/*
+		- Sets the given bit.
+		*/
+		void set(int bit);
+
+		/*
+		- Clears the given bit.
+		*/
+		void reset(int bit);
+	};
+
+
+	/*
+	- A view of a vector of element pointers, skipping the null ones (e.g. the
+	empty slots of a layout), which allows visiting them without copying the
+	vector.
+	- If a set of the full slots is given, runs of empty slots are skipped
+	with it instead of checking them one by one.
+	- It's only valid as long as the vector isn't resized or reallocated.
+	*/
+	class elementRange
+	{
+	public:
+
+		/*
+		- Visits the elements in a range, in order.
+		*/
+		class iterator
+		{
+		protected:
+
+			/*
+			- Position of the current element in the vector.
+			*/
+			baseElement *const *position;
+
+			/*
+			- Position past the last element in the vector.
+			*/
+			baseElement *const *last;
+
+			/*
+			- Position of the first pointer in the vector, and set of the
+			positions holding an element (0 if there's none).
+			*/
+			baseElement *const *first;
+			const slotBitset *fullSlots;
+
+			/*
+			- Moves forward until the current position holds an element, or
+			until the end.
+			*/
+			void skipEmpty();
+
+		public:
+
+			/*
+			- Default constructor.
+			- Starts at the given position, or at the first element after it.
+			*/
+			iterator(baseElement *const *position, baseElement *const *last);
+
+			/*
+			- Same as the default constructor, using the set of full slots of
+			the vector starting at 'first' to skip empty ones.
+			*/
+			iterator(baseElement *const *position, baseElement *const *last,
+				baseElement *const *first, const slotBitset *fullSlots);
+
+			/*
+			- Returns the current element. The iterator MUSTN'T be at the end.
+			*/
+			baseElement& operator*();
+
+			/*
+			- Returns a pointer to the current element.
+			*/
+			baseElement* operator->();
+
+			/*
+			- Moves on to the next element.
+			*/
+			iterator& operator++();
+
+			/*
+			- Moves on to the next element, returning a copy of the iterator
+			before moving.
+			*/
+			iterator operator++(int);
+
+			/*
+			- Returns 'true' if both iterators are at the same position.
+			*/
+			bool operator==(const iterator &other) const;
+
+			/*
+			- Returns 'true' if the iterators are at different positions.
+			*/
+			bool operator!=(const iterator &other) const;
+		};
+
+	protected:
+
+		/*
+		- Position of the first pointer in the vector.
+		*/
+		baseElement *const *first;
+
+		/*
+		- Position past the last pointer in the vector.
+		*/
+		baseElement *const *last;
+
+		/*
+		- Set of the positions in the vector holding an element, if known.
+		*/
+		const slotBitset *fullSlots;
 
 	public:
 
 		/*
 		- Default constructor.
-		- The layout is initially empty.
+		- Creates an empty range.
 		*/
-		baseFreeLayout(int size = 0, ALIGNMENT defaultAlignmentX = left,
-			ALIGNMENT defaultAlignmentY = top, bool elastic = true);
+		elementRange();
 
 		/*
-		- Default destructor.
+		- Creates a range over the given vector.
 		*/
-		virtual ~baseFreeLayout();
+		elementRange(const std::vector<baseElement*> &elements);
 
 		/*
-		- Returns the size of the layout (i.e. that of the 'elements' vector).
+		- Creates a range over the given vector, whose full positions are the
+		ones in the given set (which must have the same size).
 		*/
-		int get_size();
+		elementRange(const std::vector<baseElement*> &elements,
+			const slotBitset &fullSlots);
 
 		/*
-		- Returns the value of the attribute 'elementCount'.
+		- Returns an iterator at the first element.
 		*/
-		int get_element_count();
-		
+		iterator begin() const;
+
 		/*
-		- Returns the value of the attribute 'lowestEmptySlot'.
+		- Returns an iterator past the last element.
 		*/
-		int get_lowest_empty_slot();
-		
+		iterator end() const;
+
 		/*
-		- Returns the value of the attribute 'highestFullSlot'.
+		- Returns 'true' if there are no elements in the range.
 		*/
-		int get_highest_full_slot();
-		
+		bool empty() const;
+
 		/*
-		- Returns the value of the attribute 'defaultAlignmentX'.
+		- Returns the number of elements in the range.
+		- The pointers (or the bits of the set of full positions, if there's
+		one) are counted every time.
 		*/
-		ALIGNMENT get_default_alignment_x();
+		int size() const;
+	};
+
+
+	/*
+	- Groups elements together.
+	- Allows storage, retrieval, and simultaneous event handling.
+	*/
+	class elementHandler
+	{
+	protected:
 
 		/*
-		- Returns the value of the attribute 'defaultAlignmentY'.
+		- The elements in the handler, in no particular order.
+		- There can be no repeated elements.
 		*/
-		ALIGNMENT get_default_alignment_y();
+		std::vector<baseElement*> elements;
 
 		/*
-		- Returns the value of the attribute 'elastic'.
+		- Elements in the handler, by name.
 		*/
-		bool get_elasticity();
-		
+		nameIndex names;
+
 		/*
-		- Returns 'true' if the given slot (a position in 'elements') has
-		an element, or 'false' if it's empty.
+		- An element in the handler with an event under some name.
 		*/
-		bool is_slot_full(int slotNumber);
-		
+		struct subscriber
+		{
+			/*
+			- The element.
+			*/
+			baseElement *element;
+
+			/*
+			- The element's event.
+			*/
+			event *subscribedEvent;
+		};
+
 		/*
-		- Returns a pointer to the element in the specified slot, or null if
-		it's empty.
-		- Can be redefined in derived classes.
+		- For every event name, the elements in the handler with an event under
+		that name, sorted by id.
+		- Used so that activating events only visits the elements concerned.
 		*/
-		virtual baseElement* get_element(int slotNumber);
+		std::map<std::string, std::vector<subscriber> > subscribers;
 
 		/*
-		- Returns a copy of the 'elements' vector.
+		- Number of times 'subscribers' has changed.
+		- Loops activating many events compare it after every effect, and look
+		up their list again only if it has changed.
 		*/
-		std::vector<baseElement*> get_elements();
+		int subscriberChanges;
 
 		/*
-		- Changes the position of the layout's content.
-		- Position and size of slots inside the layout are recalculated
-		(relevant for derived classes).
+		- Returns 'true' if the subscriber's element has a lower id than the
+		given one. Used to keep subscribers sorted.
 		*/
-		void set_content_position(float contentPosX, float contentPosY);
+		static bool hasLowerId(const subscriber &s, long long elementId);
 
 		/*
-		- Changes the size of the layout's content.
-		- Position and size of slots inside the layout are recalculated
-		(relevant for derived classes).
+		- Adds (or updates) an element's event to 'subscribers'.
 		*/
-		void set_content_size(float contentWidth, float contentHeight);
-		
+		void subscribe(baseElement &element, const std::string &eventName,
+			event &e);
+
 		/*
-		- Resizes the layout (i.e. resizes the 'elements' vector).
-		- If the value changes, position and size of slots inside the layout are
-		recalculated (relevant for derived classes).
+		- Removes an element's event from 'subscribers' (if it's in it).
 		*/
-		virtual void set_size(int size);
+		void unsubscribe(baseElement &element, const std::string &eventName);
 
 		/*
-		- Sets the attribute 'defaultAlignmentX'.
-		- Invalid values leave it unchanged.
+		- Returns the first subscriber to an event whose element has a higher
+		id than the given one, or 0 if there isn't any.
+		- Used to traverse subscribers while effects add or remove events or
+		elements, since these may erase (or reallocate) the list of subscribers.
 		*/
-		void set_default_alignment_x(ALIGNMENT defaultAlignmentX);
+		subscriber* nextSubscriber(const std::string &eventName,
+			long long elementId);
 
 		/*
-		- Sets the attribute 'defaultAlignmentY'.
-		- Invalid values leave it unchanged.
+		- Returns a pointer to the element in the handler with the given name,
+		or 0 if there's none.
+		- If there are several, it's the one with the lowest id.
 		*/
-		void set_default_alignment_y(ALIGNMENT defaultAlignmentY);
+		baseElement* findByName(const char *elementName, std::size_t length);
 
 		/*
-		- Sets the default alignment of the layout for both axis.
+		- Size of the (square) cells of the spatial index.
+		- If 0, there is no spatial index.
 		*/
-		void set_default_alignment(ALIGNMENT defaultAlignmentX,
-			ALIGNMENT defaultAlignmentY);
-		
+		float cellSize;
+
+		/*
+		- Spatial index. A uniform grid storing, for every cell, the elements
+		whose slot or content frame overlaps it.
+		- Only the cells with elements are stored, by their key (see 'cellKey').
+		*/
+		std::unordered_map<long long, std::vector<baseElement*> > cells;
+
+		/*
+		- A range of cells of the spatial index (bounds included).
+		*/
+		struct cellRange
+		{
+			int minX, minY, maxX, maxY;
+		};
+
+		/*
+		- The cells where an element is stored in the spatial index.
+		*/
+		struct elementCells
+		{
+			/*
+			- Cells overlapped by the element's slot frame.
+			*/
+			cellRange slotCells;
+
+			/*
+			- Cells overlapped by the element's content frame.
+			*/
+			cellRange contentCells;
+
+			/*
+			- 'true' if any of the frames overlaps more than 'maxFrameCells'
+			cells, in which case the element is stored in 'bigElements'
+			instead.
+			*/
+			bool big;
+		};
+
+		/*
+		- Cells where every element in the spatial index is stored.
+		*/
+		std::unordered_map<baseElement*, elementCells> indexedCells;
+
+		/*
+		- Elements too big for the spatial index. They're checked for any
+		position.
+		*/
+		std::vector<baseElement*> bigElements;
+
+		/*
+		- Maximum number of cells a frame can overlap in the spatial index.
+		*/
+		static const int maxFrameCells = 64;
+
+		/*
+		- Elements found by the last call to 'findIdsAt', kept so their memory
+		can be reused.
+		*/
+		std::vector<baseElement*> hitElements;
+
+		/*
+		- Ids found by the last call to 'activate_events_at', kept so their
+		memory can be reused.
+		*/
+		std::vector<long long> hitIds;
+
+		/*
+		- Stores in the given vector the ids of the elements 'find_elements_at'
+		finds at the given position, in increasing order.
+		- Used to activate their events, since effects may delete elements
+		(whose ids then find nothing).
+		*/
+		void findIdsAt(float posX, float posY, std::vector<long long> &ids);
+
+		/*
+		- For every geometry store holding elements of the handler, the number
+		of them it holds.
+		- While they're all in the same store, 'find_elements_at' reads its
+		arrays instead of visiting the elements.
+		*/
+		std::map<geometryStore*, int> storedElements;
+
+		/*
+		- Indices found in a geometry store by the last call to
+		'find_elements_at', kept so their memory can be reused.
+		*/
+		std::vector<int> storedHits;
+
+		/*
+		- Adds a number (which may be negative) to the count of elements in the
+		handler held by a geometry store (if not null).
+		*/
+		void countStored(geometryStore *store, int count);
+
+		/*
+		- Returns the position of the handler in the attribute 'handlers' of
+		the element, or -1 if the element isn't in the handler.
+		*/
+		int handlerIndex(baseElement &element);
+
+		/*
+		- Returns the key of the cell in the given column and row.
+		*/
+		static long long cellKey(int cellX, int cellY);
+
+		/*
+		- Returns the column (or row) of the cells containing the given X (or Y)
+		coordinate.
+		*/
+		int cellCoordinate(float pos);
+
+		/*
+		- Returns the range of cells overlapped by the given frame.
+		*/
+		cellRange getCellRange(float posX, float posY, float width,
+			float height);
+
+		/*
+		- Returns the cells overlapped by the slot and content frames of an
+		element.
+		*/
+		elementCells getElementCells(baseElement &element);
+
+		/*
+		- Returns 'true' if the given cell is in the range.
+		*/
+		static bool isInRange(const cellRange &range, int cellX, int cellY);
+
+		/*
+		- Returns 'true' if both ranges contain the same cells.
+		*/
+		static bool isSameRange(const cellRange &range1,
+			const cellRange &range2);
+
+		/*
+		- Stores an element in the given cells of the spatial index (or in
+		'bigElements').
+		*/
+		void addToCells(baseElement &element, const elementCells &where);
+
+		/*
+		- Removes an element from the given cells of the spatial index (or from
+		'bigElements').
+		*/
+		void removeFromCells(baseElement &element, const elementCells &where);
+
+		/*
+		- Adds an element to the spatial index, or updates its cells if it was
+		already in it.
+		*/
+		void indexGeometry(baseElement &element);
+
+		/*
+		- Removes an element from the spatial index (if it's in it).
+		*/
+		void unindexGeometry(baseElement &element);
+
+		/*
+		- Returns 'true' if the given element has a lower id than the other.
+		Used to sort elements found in the spatial index.
+		*/
+		static bool hasLowerElementId(baseElement *element1,
+			baseElement *element2);
+
+		/*
+		- Returns 'true' if the slot or content frame of the element contains
+		the given position.
+		*/
+		static bool isElementAt(baseElement &element,
+			const positionArguments &position);
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		elementHandler();
+
+		/*
+		- Copy constructor.
+		- The new handler contains pointers to the same elements as the source.
+		*/
+		elementHandler(elementHandler &handler);
+
+		/*
+		- Default destructor.
+		- Elements in the handler are removed from it, but not destroyed.
+		*/
+		~elementHandler();
+
+		/*
+		- Returns a map of the elements in the handler, with their id as the
+		key.
+		- The map is built on every call. 'get_element_range' doesn't copy
+		anything.
+		*/
+		std::map<long long, baseElement*> get_map();
+
+		/*
+		- Returns a reference to the elements in the handler, in no particular
+		order.
+		- The reference is only valid until elements are added or removed.
+		*/
+		const std::vector<baseElement*>& get_elements();
+
+		/*
+		- Returns a view of the elements in the handler, in no particular order,
+		without copying them.
+		- The view is only valid until elements are added or removed.
+		*/
+		elementRange get_element_range();
+
+		/*
+		- Makes the received handler into a copy of the current handler.
+		- The received one contains pointers to the same elements as the source.
+		*/
+		void copy(elementHandler &handler);
+
+		/*
+		- Returns a pointer to the element in the handler with the given id.
+		- If no element with that id is found, the return value is 0.
+		*/
+		baseElement* find_element(long long elementId);
+
+		/*
+		- Returns a pointer to the element in the handler with the given name.
+		- If no element with that name is found, the return value is 0.
+		*/
+		baseElement* find_element(const std::string &elementName);
+
+		/*
+		- Same as 'find_element(elementName)', taking a null-terminated string.
+		*/
+		baseElement* find_element(const char *elementName);
+
+#ifdef LAYOUT_STRING_VIEW
+		/*
+		- Same as 'find_element(elementName)', taking a string view.
+		*/
+		baseElement* find_element(std::string_view elementName);
+#endif
+
+		/*
+		- Adds the given element to the handler.
+		*/
+		void add_element(baseElement &element);
+
+		/*
+		- Recursively adds to the handler the layout and every element in it.
+		*/
+		void r_add_element(baseElement &element);
+
+		/*
+		- Removes from the handler the given element (if present).
+		*/
+		void remove_element(baseElement &element);
+
+		/*
+		- Removes from the handler the given element (if present).
+		- If the element is a layout, every element inside it is also
+		recursively removed.
+		*/
+		void r_remove_element(baseElement &element);
+
+		/*
+		- For all elements in the handler, activates the events identified by a
+		given string.
+		- Only the elements with an event under that name are visited, in order
+		of their id.
+		- New maps of arguments for condition and effect methods can be
+		provided, in which case they will be added to the default maps.
+		- If an argument is provided under the same string that an existing
+		default argument, the new one overwrites the default one.
+		*/
+		void activate_events(std::string eventName,
+			std::map<std::string, void*> &conditionArgs =
+			std::map<std::string, void*>::map<std::string, void*>(),
+			std::map<std::string, void*> &effectArgs =
+			std::map<std::string, void*>::map<std::string, void*>());
+
+		/*
+		- For all elements in the handler, activates the typed events (see
+		'typedEvent') identified by a given string whose condition arguments
+		are of the given type.
+		- Other events under that name are ignored.
+		*/
+		template <class conditionArgs>
+		void activate_events(const std::string &eventName,
+			const conditionArgs &args);
+
+		/*
+		- Returns the size of the cells of the spatial index, or 0 if the
+		handler has none.
+		*/
+		float get_spatial_index();
+
+		/*
+		- Builds a spatial index of the elements in the handler, using square
+		cells of the given size. It's kept up to date as elements move.
+		- It should be about the size of the elements. If 0 (or less), the
+		handler has no spatial index.
+		*/
+		void set_spatial_index(float cellSize);
+
+		/*
+		- Stores in the given vector the elements in the handler whose slot or
+		content frame contains the given position, in order of their id.
+		- Uses the spatial index, if there's one. Otherwise, if all elements
+		are in the same geometry store (and it isn't much bigger than the
+		handler), its arrays are read instead of the elements.
+		*/
+		void find_elements_at(float posX, float posY,
+			std::vector<baseElement*> &found);
+
+		/*
+		- Same as 'activate_events', but only for the elements whose slot or
+		content frame contains the given position (see 'find_elements_at').
+		- Their event conditions are checked as usual, so the result is the
+		same as that of 'activate_events' for events that can only happen
+		within those frames (such as those using 'position_inside_slot_frame'
+		and 'position_inside_content_frame').
+		*/
+		void activate_events_at(std::string eventName, float posX, float posY,
+			std::map<std::string, void*> &conditionArgs =
+			std::map<std::string, void*>::map<std::string, void*>(),
+			std::map<std::string, void*> &effectArgs =
+			std::map<std::string, void*>::map<std::string, void*>());
+
+		/*
+		- Same as 'activate_events_at', for typed events receiving the position
+		as their condition arguments.
+		*/
+		void activate_events_at(const std::string &eventName,
+			const positionArguments &args);
+
+		/*
+		- Activates the events identified by a given string once for each of
+		the given positions, which are passed on to the conditions as the
+		arguments "posX" and "posY" (overwriting any given ones). Typed events
+		receiving a 'positionArguments' are activated with the position.
+		- Events using 'position_inside_slot_frame' or
+		'position_inside_content_frame' are checked for all the elements at
+		once: their frames are read at the start, and each position is tested
+		against all of them together (with SSE2 or AVX2 when available). Only
+		the effects of those containing it are activated.
+		- For each position, events are activated in order of their element's
+		id, as in 'activate_events'.
+		*/
+		void activate_events_batch(std::string eventName, int positionCount,
+			const float *posX, const float *posY,
+			std::map<std::string, void*> &conditionArgs =
+			std::map<std::string, void*>::map<std::string, void*>(),
+			std::map<std::string, void*> &effectArgs =
+			std::map<std::string, void*>::map<std::string, void*>());
+
+		/*
+		- Methods 'set_name', 'set_events', 'add_event' and 'remove_event' from
+		'baseElement' need to update the attributes 'names' and 'subscribers'.
+		*/
+		friend class baseElement;
+
+		/*
+		- Geometry stores call 'countStored' when elements join or leave them.
+		*/
+		friend class geometryStore;
+	};
+	
+
+	/*
+	- A read-only view of the arguments passed on to an event's condition or
+	effect.
+	- Arguments are looked up first among those given on activation, and then
+	among the event's default ones, without copying any of them.
+	*/
+	class argumentView
+	{
+	protected:
+
+		/*
+		- Arguments given on activation. They take precedence.
+		*/
+		std::map<std::string, void*> *args;
+
+		/*
+		- Default arguments, or 0 if there are none.
+		*/
+		std::map<std::string, void*> *defaultArgs;
+
+		/*
+		- Values of the arguments "posX" and "posY", taking precedence over
+		any others, or 0 if they're looked up as usual.
+		*/
+		float *posX, *posY;
+
+		/*
+		- Looks up an argument by name. If found, stores its value in the given
+		pointer and returns 'true'.
+		*/
+		bool lookup(const std::string &argName, void *&argValue) const;
+
+	public:
+
+		/*
+		- Constructor for a single map of arguments.
+		- It allows maps to be passed on where a view is expected.
+		*/
+		argumentView(std::map<std::string, void*> &args);
+
+		/*
+		- Constructor for arguments with defaults.
+		*/
+		argumentView(std::map<std::string, void*> &args,
+			std::map<std::string, void*> &defaultArgs);
+
+		/*
+		- Constructor for arguments with defaults, where the arguments "posX"
+		and "posY" point to the given position whatever the maps hold.
+		- It lets a position be added to the arguments without copying them.
+		*/
+		argumentView(float &posX, float &posY,
+			std::map<std::string, void*> &args,
+			std::map<std::string, void*> &defaultArgs);
+
+		/*
+		- Returns 'true' if there is an argument with the given name.
+		*/
+		bool has(const std::string &argName) const;
+
+		/*
+		- Returns the value of the argument with the given name, or 0 if there
+		is none.
+		*/
+		void* get(const std::string &argName) const;
+
+		/*
+		- Stores in the given map every argument in the view (defaults included).
+		- Used to call functions expecting a map of arguments.
+		*/
+		void to_map(std::map<std::string, void*> &argMap) const;
+	};
+
+
+	/*
+	- An event. An association of a condition and an effect.
+	- Conditions and effects may receive their arguments either as an
+	'argumentView' or as a map. Maps have to be built on every activation, so
+	views should be preferred.
+	*/
+	class event
+	{
+	protected:
+
+		/*
+		- Type redefinitions for pointers to functions.
+		- These redefinitions make it easier to manage the types while using
+		them in method arguments or return values.
+		*/
+		typedef bool (*eventConditionType)(std::map<std::string, void*>&);
+		typedef void (*eventEffectType)(std::map<std::string, void*>&);
+		typedef bool (*viewConditionType)(const argumentView&);
+		typedef void (*viewEffectType)(const argumentView&);
+
+		/*
+		- A method implementing the condition to decide if the event effect
+		should be triggered.
+		- Without a condition, the effect (if any) will always be triggered
+		upon activation.
+		*/
+		eventConditionType eventCondition;
+
+		/*
+		- Same as 'eventCondition', for conditions receiving a view of their
+		arguments. Only one of them can be set.
+		*/
+		viewConditionType viewCondition;
+		
+		/*
+		- A method implementing the effect of the event.
+		- Without an effect, nothing will be triggered upon activation.
+		*/
+		eventEffectType eventEffect;
+
+		/*
+		- Same as 'eventEffect', for effects receiving a view of their
+		arguments. Only one of them can be set.
+		*/
+		viewEffectType viewEffect;
+
+		/*
+		- The set of arguments passed on by default to the condition function.
+		*/
+		std::map<std::string, void*> defaultConditionArgs;
+
+		/*
+		- The set of arguments passed on by default to the effect function.
+		*/
+		std::map<std::string, void*> defaultEffectArgs;
+
+		/*
+		- Activates the effect (if any) without checking the condition.
+		- The given arguments are added to the default ones, as in 'activate'.
+		*/
+		void activateEffect(std::map<std::string, void*> &effectArgs);
+
+		/*
+		- Same as 'activate', but the condition receives the given view of its
+		arguments (which should include the default ones).
+		*/
+		bool activateView(const argumentView &conditionArgs,
+			std::map<std::string, void*> &effectArgs);
+
+		/*
+		- If 'false', events routed through a layout (see
+		'baseFreeLayout::route_event') stop at this one when it's fulfilled,
+		without reaching the layouts containing its element.
+		*/
+		bool propagates;
+
+		/*
+		- Identifies the type of condition arguments of a typed event (see
+		'typedEventBase'). It's 0 for other events.
+		*/
+		const void *argumentsType;
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		event(eventConditionType eventCondition = 0,
+			eventEffectType eventEffect = 0,
+			std::map<std::string, void*> &defaultConditionArgs =
+			std::map<std::string, void*>::map<std::string, void*>(),
+			std::map<std::string, void*> &defaultEffectArgs =
+			std::map<std::string, void*>::map<std::string, void*>());
+
+		/*
+		- Returns a pointer to the event condition function.
+		- It's 0 if the condition receives a view of its arguments.
+		*/
+		eventConditionType get_event_condition();
+
+		/*
+		- Returns a pointer to the event condition function receiving a view of
+		its arguments (or 0 if it receives a map).
+		*/
+		viewConditionType get_event_view_condition();
+
+		/*
+		- Returns a pointer to the event effect function..
+		- It's 0 if the effect receives a view of its arguments.
+		*/
+		eventEffectType get_event_effect();
+
+		/*
+		- Returns a pointer to the event effect function receiving a view of
+		its arguments (or 0 if it receives a map).
+		*/
+		viewEffectType get_event_view_effect();
+
+		/*
+		- Returns a reference to the attribute 'defaultConditionArgs'.
+		*/
+		std::map<std::string, void*>& get_default_condition_args();
+
+		/*
+		- Returns a reference to the attribute 'defaultEffectArgs'.
+		*/
+		std::map<std::string, void*>& get_default_effect_args();
+
+		/*
+		- Returns the value of the attribute 'propagates'.
+		*/
+		bool get_propagation();
+
+		/*
+		- Sets the pointer to the event condition function.
+		*/
+		void set_event_condition(eventConditionType eventCondition);
+
+		/*
+		- Sets the pointer to the event condition function, for one receiving a
+		view of its arguments.
+		*/
+		void set_event_condition(viewConditionType viewCondition);
+
+		/*
+		- Sets the pointer to the event effect function.
+		*/
+		void set_event_effect(eventEffectType eventEffect);
+
+		/*
+		- Sets the pointer to the event effect function, for one receiving a
+		view of its arguments.
+		*/
+		void set_event_effect(viewEffectType viewEffect);
+
+		/*
+		- Sets the attribute 'defaultConditionArgs' as a copy of the given map.
+		*/
+		void set_default_condition_args(
+			std::map<std::string, void*> &defaultConditionArgs);
+
+		/*
+		- Sets the attribute 'defaultEffectArgs' as a copy of the given map.
+		*/
+		void set_default_effect_args(
+			std::map<std::string, void*> &defaultEffectArgs);
+
+		/*
+		- Sets the value of the attribute 'propagates'.
+		*/
+		void set_propagation(bool propagates);
+
+		/*
+		- Adds an argument to the default condition map.
+		- If there is already an argument with that name, it's overwritten.
+		*/
+		void add_default_condition_argument(std::string argName,
+			void *argValue);
+
+		/*
+		- Adds an argument to the default effect map.
+		- If there is already an argument with that name, it's overwritten.
+		*/
+		void add_default_effect_argument(std::string argName, void *argValue);
+
+		/*
+		- If it exists, removes the argument with the given name from the
+		default condition map.
+		*/
+		void remove_default_condition_argument(std::string argName);
+
+		/*
+		- If it exists, removes the argument with the given name from the
+		default effect map.
+		*/
+		void remove_default_effect_argument(std::string argName);
+
+		/*
+		- Checks that the codition is fulfilled, and if so activates the effect.
+		- The method receives up to two argument maps, to be passed on to the
+		condition and effect methods respectively.
+		- Arguments are passed on as views of the given maps and the default
+		ones, so nothing is copied unless the condition or effect expects a map.
+		- Returns 'true' if the effect was activated.
+		*/
+		bool activate(std::map<std::string, void*> &conditionArgs =
+			std::map<std::string, void*>::map<std::string, void*>(),
+			std::map<std::string, void*> &effectArgs =
+			std::map<std::string, void*>::map<std::string, void*>());
+
+		/*
+		- Default destructor.
+		*/
+		virtual ~event();
+
+		/*
+		- The typed version of 'activate_events' in 'elementHandler' needs to
+		read the attribute 'argumentsType', and 'activate_events_batch' needs
+		to read the conditions and activate effects on their own.
+		*/
+		friend class elementHandler;
+
+		/*
+		- Method 'route_event' from 'baseFreeLayout' needs to read the
+		attributes 'argumentsType' and 'propagates'.
+		*/
+		friend class baseFreeLayout;
+	};
+
+
+	/*
+	- An event whose condition receives its arguments as an object of the given
+	type instead of a map, along with the element the event belongs to.
+	- Its type can be checked without 'dynamic_cast', so handlers can activate
+	typed events with the right arguments and skip the others.
+	- This class shouldn't be instanced, but serve as a base for 'typedEvent'.
+	*/
+	template <class conditionArgs>
+	class typedEventBase : public event
+	{
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		typedEventBase();
+
+		/*
+		- Returns the value identifying events with conditions receiving
+		arguments of type 'conditionArgs'.
+		*/
+		static const void* arguments_type();
+
+		/*
+		- Checks that the condition is fulfilled for the given element and
+		arguments, and if so activates the effect.
+		- Returns 'true' if the effect was activated.
+		- Must be redefined in derived classes.
+		*/
+		virtual bool activate(baseElement &element,
+			const conditionArgs &args) = 0;
+
+		/*
+		- For the original overload of 'activate'.
+		- Typed events have no condition or effect receiving maps, so it does
+		nothing on them.
+		*/
+		using event::activate;
+	};
+
+
+	/*
+	- An event whose condition and effect receive their arguments as objects of
+	the given types (for instance, plain structs), so that they're read without
+	any lookup or cast.
+	- Condition arguments are given on activation. Effect arguments are stored
+	in the event.
+	- Both functions also receive the element the event was activated for.
+	*/
+	template <class conditionArgs, class effectArgs>
+	class typedEvent : public typedEventBase<conditionArgs>
+	{
+	protected:
+
+		/*
+		- Type redefinitions for pointers to functions.
+		*/
+		typedef bool (*typedConditionType)(baseElement&, const conditionArgs&);
+		typedef void (*typedEffectType)(baseElement&, const effectArgs&);
+
+		/*
+		- A method implementing the condition to decide if the event effect
+		should be triggered.
+		- Without a condition, the effect (if any) will always be triggered
+		upon activation.
+		*/
+		typedConditionType typedCondition;
+
+		/*
+		- A method implementing the effect of the event.
+		- Without an effect, nothing will be triggered upon activation.
+		*/
+		typedEffectType typedEffect;
+
+		/*
+		- The arguments passed on to the effect function.
+		*/
+		effectArgs effectArguments;
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		typedEvent(typedConditionType typedCondition = 0,
+			typedEffectType typedEffect = 0,
+			const effectArgs &effectArguments = effectArgs());
+
+		/*
+		- Returns a pointer to the event condition function.
+		*/
+		typedConditionType get_event_condition();
+
+		/*
+		- Returns a pointer to the event effect function.
+		*/
+		typedEffectType get_event_effect();
+
+		/*
+		- Returns a reference to the attribute 'effectArguments'.
+		*/
+		effectArgs& get_effect_args();
+
+		/*
+		- Sets the pointer to the event condition function.
+		*/
+		void set_event_condition(typedConditionType typedCondition);
+
+		/*
+		- Sets the pointer to the event effect function.
+		*/
+		void set_event_effect(typedEffectType typedEffect);
+
+		/*
+		- Sets the attribute 'effectArguments' as a copy of the given object.
+		*/
+		void set_effect_args(const effectArgs &effectArguments);
+
+		/*
+		- Checks that the condition is fulfilled for the given element and
+		arguments, and if so activates the effect.
+		- Returns 'true' if the effect was activated.
+		*/
+		virtual bool activate(baseElement &element, const conditionArgs &args);
+
+		/*
+		- For the original overload of 'activate'.
+		*/
+		using typedEventBase<conditionArgs>::activate;
+	};
+
+	
+	/*
+	- A layout (a series of slots where elements can be allocated).
+	- The position and size of slots in a free layout are not restricted by
+	the bounds of the layout content. Slots can overlap.
+	- By default, newly added elements keep their content bounds and alignment.
+	- This class shouldn't be instanced, but serve as a base for other classes.
+	*/
+	class baseFreeLayout : public virtual baseElement
+	{
+	protected:
+		
+		/*
+		- Vector storing the pointers to all the elements inside the layout.
+		- Its size is the size of the layout (number of available slots).
+		- With sparse storage (see 'sparse'), it only stores the elements, in
+		slot order, and positions in it aren't slot numbers.
+		*/
+		std::vector<baseElement*> elements;
+
+		/*
+		- If 'true', the layout uses sparse storage: 'elements' has no empty
+		slots and the size of the layout is 'sparseSize', so huge and mostly
+		empty layouts neither store nor visit their empty slots.
+		- Slots are found by binary search, which makes adding and removing
+		elements linear on their number (not on the size).
+		*/
+		bool sparse;
+
+		/*
+		- Size of the layout when it uses sparse storage (0 otherwise).
+		*/
+		int sparseSize;
+
+		/*
+		- Fraction of full slots under which the layout switches to sparse
+		storage by itself, when its size changes or elements are added. It
+		switches back to dense storage when twice as many slots are full.
+		- If 0, storage is only changed by hand (see 'set_sparse').
+		*/
+		float sparseDensity;
+
+		/*
+		- Number of elements inside the layout (or number of full slots).
+		- Always less than or equal to the size of the layout.
+		*/
+		int elementCount;
+		
+		/*
+		- Position of the lowest empty slot in the 'elements' vector.
+		- Technically, the first null position in 'elements'.
+		- If a layout has no elements, its value is 0.
+		*/
+		int lowestEmptySlot;
+		
+		/*
+		- Position of the highest full slot in the 'elements' vector.
+		- Technically, the last non-null position in 'elements'.
+		- If a layout has no elements, its value is -1.
+		*/
+		int highestFullSlot;
+
+		/*
+		- Set of the full slots (the non-null positions in 'elements'), kept
+		with the same size.
+		- With sparse storage, every position in 'elements' is full, so all
+		its bits are set.
+		- Used to find empty and full slots, and to skip runs of empty ones,
+		without checking slots one by one.
+		*/
+		slotBitset fullSlots;
+
+		/*
+		- Slot positions and sizes calculated by 'calculateSlotRects', kept
+		between calls to 'recalculateAllSlotBounds' so they don't allocate.
+		*/
+		std::vector<float> slotScratch;
+
+		/*
+		- Alignment on X of newly added elements will be changed to this value.
+		- Valid values are 'none', 'left', 'right', 'center', and 'keep'.
+		- 'keep' causes newly added elements to retain their original values.
+		*/
+		ALIGNMENT defaultAlignmentX;
+
+		/*
+		- Alignment on Y of newly added elements will be changed to this value.
+		- Valid values are 'none', 'top', 'bottom', 'center', and 'keep'.
+		- 'keep' causes newly added elements to retain their original values.
+		*/
+		ALIGNMENT defaultAlignmentY;
+		
+		/*
+		- If 'true', adding elements in slots greater than the layout's size
+		will cause the layout to be resized to fit them.
+		- If 'false', those elements cannot be added.
+		*/
+		bool elastic;
+
+		/*
+		- 'true' if the slots of the elements inside the layout have to be
+		recalculated on the next call to 'update_layout'.
+		*/
+		bool slotsDirty;
+
+		/*
+		- Number of times 'begin_update' has been called on the layout without
+		its matching 'end_update'.
+		*/
+		int updateDepth;
+
+		/*
+		- Visible elements of the layout, in the order they are drawn (from
+		greater to lesser depth, and by slot number within the same depth).
+		- It's only sorted again after being marked.
+		*/
+		std::vector<baseElement*> drawOrder;
+
+		/*
+		- 'true' if 'drawOrder' has to be sorted again before being used.
+		- Set when an element is added or removed, or when the depth or
+		visibility of an element inside the layout changes.
+		*/
+		bool drawOrderDirty;
+
+		/*
+		- 'true' if the drawing order of the layout or of any layout inside it
+		has changed since it was last cleared.
+		- It's cleared with 'clear_draw_tree_dirty' (e.g. by display lists, see
+		'SFMLLayout.hpp') once the layout's subtree has been flattened again.
+		*/
+		bool drawTreeDirty;
+
+		/*
+		- Every element in the layout (or in a sublayout), by name, if the
+		layout isn't inside another one.
+		- Otherwise it's empty, and the outermost layout containing it indexes
+		its elements, so that every element is indexed only once.
+		*/
+		nameIndex names;
+
+		/*
+		- Returns the outermost layout containing the layout (or the layout
+		itself, if it isn't inside another one), whose name index holds the
+		elements inside it.
+		*/
+		baseFreeLayout* indexingLayout();
+
+		/*
+		- Adds an element (and the elements inside it, if it's a layout) to the
+		name index of the outermost layout containing the layout.
+		*/
+		void indexElement(baseElement &element);
+
+		/*
+		- Removes an element (and the elements inside it, if it's a layout) from
+		the name index of the outermost layout containing the layout.
+		- A removed layout indexes the elements inside it again.
+		*/
+		void unindexElement(baseElement &element);
+
+		/*
+		- Resizes 'elements', removing from the layout any element that doesn't
+		fit anymore.
+		*/
+		void resizeElements(int size);
+
+		/*
+		- Grows 'elements' to the given size (if smaller), with at least twice
+		its old capacity when it has to be reallocated.
+		*/
+		void growElements(int size);
+
+		/*
+		- Puts an element (without parent layout) in an existing slot, removing
+		the old one (if any), without recalculating its slot or the slot
+		counters.
+		- Used by 'add_element' and 'add_elements'.
+		*/
+		void placeElement(baseElement &element, int slotNumber);
+
+		/*
+		- Adds the given elements to consecutive slots from the specified one,
+		or to the lowest free slots if it's negative.
+		- Used by both overloads of 'add_elements'.
+		*/
+		void placeElements(const std::vector<baseElement*> &newElements,
+			int slotNumber);
+
+		/*
+		- Returns the position in 'elements' of the first element with the
+		given slot or a higher one (for sparse storage).
+		*/
+		int findPosition(int slotNumber);
+
+		/*
+		- Moves the elements to sparse storage or back to dense storage.
+		*/
+		void convertStorage(bool sparse);
+
+		/*
+		- Changes the storage of the layout if its density of full slots has
+		crossed the limits given by 'sparseDensity'.
+		*/
+		void checkDensity();
+
+		/*
+		- Returns 'true' if the layout can use sparse storage, which requires
+		the slots not to depend on the size of the layout.
+		- In this case (free layout) it returns 'true'.
+		- Can be redefined in derived classes.
+		*/
+		virtual bool supportsSparseSlots();
+
+		/*
+		- Gives the received layout as many slots as the current one, and the
+		same slot counters. Its slots must be empty, and be filled afterwards
+		with copies of the current layout's elements.
+		- Used by 'r_copy', which fills the slots of each copied layout in turn.
+		*/
+		void copySlots(baseFreeLayout &layout);
+
+		/*
+		- Returns 'true' if the first element is found before the second one by
+		a depth-first search of the layout (both must be inside it).
+		*/
+		bool isFoundBefore(baseElement *element1, baseElement *element2);
+
+		/*
+		- Returns 'true' if the element is inside the layout (or in a
+		sublayout).
+		*/
+		bool contains(baseElement &element);
+
+		/*
+		- Returns a pointer to the element in the layout (or in a sublayout)
+		with the given name, or 0 if there's none.
+		- If there are several, it's the first one a depth-first search would
+		find.
+		*/
+		baseElement* findByName(const char *elementName, std::size_t length);
+
+		/*
+		- Marks 'drawOrder' to be sorted again, and 'drawTreeDirty' in the
+		layout and all the layouts containing it.
+		*/
+		void markDrawOrderDirty();
+
+		/*
+		- Marks the slots of the layout for recalculation, which will take place
+		on the next call to 'update_layout'.
+		*/
+		void markSlotsDirty();
+
+		/*
+		- Bounds of the layout's subtree: the smallest rectangle containing the
+		slot and content frames of the layout and of every element inside it
+		(or inside a sublayout).
+		- Content frames are included because they may overflow their slots.
+		- Only valid if 'boundsDirty' is 'false'.
+		*/
+		float boundsMinX, boundsMinY, boundsMaxX, boundsMaxY;
+
+		/*
+		- Extends the subtree bounds to contain the given rectangle.
+		*/
+		void includeBounds(float minX, float minY, float maxX, float maxY);
+
+		/*
+		- Extends the subtree bounds to contain the given frame (its size may be
+		negative).
+		*/
+		void includeFrame(float posX, float posY, float width, float height);
+
+		/*
+		- Recalculates the subtree bounds of the layout from those of its
+		elements, whose own bounds (if they're layouts) must be up to date.
+		*/
+		void calculateBounds();
+
+		/*
+		- Recalculates the subtree bounds of the layout if they're marked, and
+		those of the sublayouts that are marked too.
+		- Sublayouts are found with a 'layoutIterator', so deep layouts can't
+		overflow the call stack.
+		*/
+		void updateBounds();
+
+		/*
+		- Finds the topmost visible element inside the layout whose slot or
+		content frame contains the given position. Sublayouts whose subtree
+		bounds don't contain it are skipped.
+		- If found, the element is appended to the path, preceded by the
+		sublayouts containing it, and 'true' is returned.
+		- Subtree bounds must be up to date.
+		- The sublayouts being searched are kept in an explicit stack, so deep
+		layouts can't overflow the call stack.
+		*/
+		bool hitTestContent(const positionArguments &position,
+			std::vector<baseElement*> &path);
+
+		/*
+		- Elements of a layout between two slots (the last one excluded), which
+		a single task updates during a parallel layout update.
+		*/
+		struct updateRange
+		{
+			baseFreeLayout *layout;
+			int first;
+			int last;
+			threadPool *pool;
+			int grainSize;
+		};
+
+		/*
+		- Returns an estimate of the work it takes to update the layout: the
+		number of elements inside it, plus the number of slots of the layouts
+		among them.
+		*/
+		int estimateWork();
+
+		/*
+		- Pool, queue and grain size of the parallel update the current thread
+		is taking part in (the pool is 0 if there's none).
+		- While it's set, 'update_layout' updates layouts large enough in
+		parallel, so that layouts reached through their own (possibly
+		redefined) 'update_layout' still split their work.
+		*/
+		static thread_local threadPool *updatePool;
+		static thread_local int updateQueue;
+		static thread_local int updateGrainSize;
+
+		/*
+		- Updates the layout like 'update_layout', but the elements inside it
+		are split into ranges of about 'grainSize' work (see 'estimateWork'),
+		all but the first of which are given to the pool. The thread calling it
+		runs tasks from the given queue of the pool.
+		- The layout and every layout containing it are marked before the
+		ranges are given out, so tasks marking the elements they update stop at
+		the layout and never write the flags they share.
+		- The layout must be marked and not be updating.
+		*/
+		void updateInParallel(threadPool &pool, int queue, int grainSize);
+
+		/*
+		- Task updating the marked elements of an 'updateRange' through their
+		'update_layout'. Layouts among them are updated in parallel if they're
+		large enough, and serially otherwise.
+		*/
+		static void updateRangeTask(void *range, int queue);
+
+		/*
+		- Returns 'true' if the first element has greater depth than the second.
+		- Used to sort 'drawOrder'.
+		*/
+		static bool hasGreaterDepth(baseElement *element1,
+			baseElement *element2);
+
+		/*
+		- Fills 'drawOrder' with the visible elements in the layout and sorts it.
+		*/
+		void sortDrawOrder();
+
+		/*
+		- Recalculates the position and size of an element's slot given its
+		position inside the 'elements' vector.
+		- In this case (free layout) it does nothing.
+		- Can be redefined in derived classes.
+		*/
+		virtual void recalculateSlotBounds(baseElement &element);
+
+		/*
+		- Calculates the position and size of every slot in the layout at once,
+		storing them in the given arrays (each the size of 'elements').
+		- Returns 'false' if the layout doesn't support it, in which case slots
+		are recalculated one at a time with 'recalculateSlotBounds'.
+		- In this case (free layout) it returns 'false'.
+		- Can be redefined in derived classes.
+		*/
+		virtual bool calculateSlotRects(float *slotPosX, float *slotPosY,
+			float *slotWidth, float *slotHeight);
+
+		/*
+		- Recalculates the slots of every element in the layout and aligns
+		their content.
+		- If possible, slots are calculated with 'calculateSlotRects' and their
+		content aligned in bulk. Otherwise, 'recalculateSlotBounds' is called
+		for every element.
+		*/
+		void recalculateAllSlotBounds();
+
+		/*
+		- Calls the 'draw' method of every element in the layout.
+		- Non-visible elements are excluded.
+		- Elements are drawn in order of greater to lesser depth, following
+		'drawOrder' (which is sorted first if needed).
+		*/
+		void drawContent();
+
+	public:
+
+		/*
+		- Default constructor.
+		- The layout is initially empty.
+		*/
+		baseFreeLayout(int size = 0, ALIGNMENT defaultAlignmentX = left,
+			ALIGNMENT defaultAlignmentY = top, bool elastic = true,
+			bool sparse = false);
+
+		/*
+		- Default destructor.
+		*/
+		virtual ~baseFreeLayout();
+
+		/*
+		- Returns the size of the layout (i.e. that of the 'elements' vector).
+		*/
+		int get_size();
+
+		/*
+		- Returns the value of the attribute 'elementCount'.
+		*/
+		int get_element_count();
+		
+		/*
+		- Returns the value of the attribute 'lowestEmptySlot'.
+		*/
+		int get_lowest_empty_slot();
+		
+		/*
+		- Returns the value of the attribute 'highestFullSlot'.
+		*/
+		int get_highest_full_slot();
+
+		/*
+		- Returns the lowest empty slot from the given one on, or the size of
+		the layout if there's none.
+		*/
+		int get_next_empty_slot(int slotNumber);
+
+		/*
+		- Returns the lowest full slot from the given one on, or the size of the
+		layout if there's none.
+		- Full slots can be visited in order with it, starting from slot 0 and
+		going on from the one after each slot found.
+		*/
+		int get_next_full_slot(int slotNumber);
+
+		/*
+		- Returns the number of full slots from 'firstSlot' up to (not
+		including) 'lastSlot'.
+		*/
+		int count_full_slots(int firstSlot, int lastSlot);
+		
+		/*
+		- Returns the value of the attribute 'defaultAlignmentX'.
+		*/
+		ALIGNMENT get_default_alignment_x();
+
+		/*
+		- Returns the value of the attribute 'defaultAlignmentY'.
+		*/
+		ALIGNMENT get_default_alignment_y();
+
+		/*
+		- Returns the value of the attribute 'elastic'.
+		*/
+		bool get_elasticity();
+
+		/*
+		- Returns the value of the attribute 'sparse'.
+		*/
+		bool get_sparse();
+
+		/*
+		- Returns the value of the attribute 'sparseDensity'.
+		*/
+		float get_sparse_density();
+		
+		/*
+		- Returns 'true' if the given slot (a position in 'elements') has
+		an element, or 'false' if it's empty.
+		*/
+		bool is_slot_full(int slotNumber);
+		
+		/*
+		- Returns a pointer to the element in the specified slot, or null if
+		it's empty.
+		- Can be redefined in derived classes.
+		*/
+		virtual baseElement* get_element(int slotNumber);
+
+		/*
+		- Returns a copy of the 'elements' vector.
+		- With sparse storage, the copy has a position for every slot anyway.
+		- 'get_element_range' visits the elements without copying it.
+		*/
+		std::vector<baseElement*> get_elements();
+
+		/*
+		- Returns a view of the elements in the layout, in slot order, skipping
+		empty slots (runs of them at once, see 'fullSlots').
+		- The view is only valid until the layout is resized (which adding
+		elements to an elastic layout may do).
+		*/
+		elementRange get_element_range();
+
+		/*
+		- Returns a reference to the visible elements of the layout, in the
+		order they are drawn. It's sorted first if needed.
+		- Iterating it in reverse gives the topmost elements first (e.g. for
+		hit-testing).
+		- The reference is only valid until elements are added or removed, or
+		their depth or visibility change.
+		*/
+		std::vector<baseElement*>& get_draw_order();
+
+		/*
+		- Returns the value of the attribute 'drawTreeDirty'.
+		*/
+		bool get_draw_tree_dirty();
+
+		/*
+		- Clears the attribute 'drawTreeDirty', once the drawing order of the
+		layout's subtree has been read again (e.g. by a display list).
+		*/
+		void clear_draw_tree_dirty();
+
+		/*
+		- Calls the visitor's 'visit' method on the layout and every element
+		inside it, in the given order, without recursion.
+		- Returns 'false' if the visitor stopped the traversal early.
+		*/
+		bool traverse(layoutVisitor &visitor, TRAVERSAL order = preorder);
+
+		/*
+		- Returns the topmost visible element (the last one drawn) whose slot or
+		content frame contains the given position. It can be the layout itself,
+		if no element inside it does. If there's none, it returns 0.
+		- Sublayouts are only searched if their subtree bounds contain the
+		position, which are kept from one call to the next and only
+		recalculated for the parts of the tree that have changed.
+		- The layout is updated first (see 'update_layout').
+		*/
+		baseElement* hit_test(float posX, float posY);
+
+		/*
+		- Same as 'hit_test(posX, posY)', also storing in the given vector the
+		path to the element found: the layout, the sublayouts containing the
+		element and the element itself. It's left empty if none is found.
+		*/
+		baseElement* hit_test(float posX, float posY,
+			std::vector<baseElement*> &path);
+
+		/*
+		- Activates the events identified by a given string along the path to
+		the topmost element under the given position (see 'hit_test'), from
+		that element up to the layout.
+		- Only the elements on the path are visited, so they don't need to be
+		in any handler. Routing stops after a fulfilled event that doesn't
+		propagate (see 'event::set_propagation').
+		- Condition and effect arguments are passed on as in
+		'elementHandler::activate_events'. Typed events receiving a
+		'positionArguments' are activated with the position instead.
+		- Returns 'true' if any event was fulfilled.
+		*/
+		bool route_event(std::string eventName, float posX, float posY,
+			std::map<std::string, void*> &conditionArgs =
+			std::map<std::string, void*>::map<std::string, void*>(),
+			std::map<std::string, void*> &effectArgs =
+			std::map<std::string, void*>::map<std::string, void*>());
+
+		/*
+		- Changes the position of the layout's content.
+		- Position and size of slots inside the layout are marked for
+		recalculation (relevant for derived classes).
+		*/
+		void set_content_position(float contentPosX, float contentPosY);
+
+		/*
+		- Changes the size of the layout's content.
+		- Position and size of slots inside the layout are marked for
+		recalculation (relevant for derived classes).
+		*/
+		void set_content_size(float contentWidth, float contentHeight);
+		
+		/*
+		- Resizes the layout (i.e. resizes the 'elements' vector).
+		- Position and size of slots inside the layout are marked for
+		recalculation (relevant for derived classes).
+		*/
+		virtual void set_size(int size);
+
+		/*
+		- Sets the attribute 'defaultAlignmentX'.
+		- Invalid values leave it unchanged.
+		*/
+		void set_default_alignment_x(ALIGNMENT defaultAlignmentX);
+
+		/*
+		- Sets the attribute 'defaultAlignmentY'.
+		- Invalid values leave it unchanged.
+		*/
+		void set_default_alignment_y(ALIGNMENT defaultAlignmentY);
+
+		/*
+		- Sets the default alignment of the layout for both axis.
+		*/
+		void set_default_alignment(ALIGNMENT defaultAlignmentX,
+			ALIGNMENT defaultAlignmentY);
+		
+		/*
+		- Sets the attribute 'elastic'.
+		*/
+		void set_elasticity(bool elasticity);
+
+		/*
+		- Moves the elements to sparse storage (see 'sparse') or back to dense
+		storage. Slot numbers don't change.
+		- Does nothing if the layout doesn't support sparse storage (see
+		'supportsSparseSlots').
+		*/
+		void set_sparse(bool sparse);
+
+		/*
+		- Sets the attribute 'sparseDensity', changing the storage of the layout
+		right away if needed.
+		*/
+		void set_sparse_density(float sparseDensity);
+
+		/*
+		- Moves the elements to the lowest slots, keeping their order, so that
+		no slot is empty before a full one.
+		- An elastic layout is also shrunk to its number of elements.
+		*/
+		void compact();
+
+		/*
+		- Recursively changes content position and size of every element inside
+		the layout, so they exactly match those of their slot.
+		*/
+		void r_match_content_to_slot();
+
+		/*
+		- Recursively changes slot position and size of every element inside
+		the layout, so they exactly match those of their slot.
+		*/
+		void r_match_slot_to_content();
+
+		/*
+		- Recursively aligns the layout and every element inside it in
+		accordance to their attributes.
+		*/
+		void r_align();
+
+		/*
+		- Recursively aligns the layout and every element inside it in
+		accordance to the parameters.
+		*/
+		void r_align(ALIGNMENT alignmentX, ALIGNMENT alignmentY);
+
+		/*
+		- Returns 'true' if the layout, or a layout containing it, has an open
+		update scope.
+		*/
+		bool is_updating();
+
+		/*
+		- Recalculates the slots of the layout (if they are marked), and then
+		updates every marked element inside it.
+		- Every marked layout in the tree is recalculated exactly once, no
+		matter how many changes were made to it since the last update.
+		- Does nothing while the layout has an open update scope, or is inside
+		a layout with one.
+		- Should be called on the outermost layout. Drawing a layout calls it
+		implicitly, and so does reading the position or size of an element
+		inside it (on the outermost marked layout containing the element).
+		While an update scope is open, those read the values before the scope.
+		*/
+		void update_layout();
+
+		/*
+		- Same as 'update_layout', but independent parts of the layout are
+		updated in parallel by the threads of the pool. The results are the
+		same as those of 'update_layout'.
+		- Layouts whose work (roughly, the elements inside them and inside the
+		layouts among them) is less than 'grainSize' are updated serially, as
+		are layouts inside them.
+		- The layout, and the elements of every layout whose work is split
+		among the threads, are updated through their own 'update_layout', so
+		redefinitions of it are still called.
+		- Elements in the layout mustn't be modified by other threads while it
+		runs.
+		*/
+		void update_layout(threadPool &pool, int grainSize = 512);
+
+		/*
+		- Opens an update scope on the layout.
+		- While it's open, slot recalculation and alignment of the layout and
+		every element inside it are postponed (positions read in the meantime
+		may be outdated).
+		- Scopes can be nested. Pending changes are applied all at once when the
+		outermost one is closed.
+		*/
+		void begin_update();
+
+		/*
+		- Closes an update scope opened with 'begin_update'.
+		- If it was the outermost scope (and the layout isn't inside another
+		layout with an open scope), the layout is updated.
+		*/
+		void end_update();
+		
+		/*
+		- Copies the current layout's attributes into the received one.
+		- Elements inside are not copied (the layout keeps its elements if any).
+		- Can be redefined in derived classes.
+		*/
+		virtual void copy(baseFreeLayout &layout);
+		
+		/*
+		- Copies the current layout's attributes into the received one.
+		- Elements inside are also recursively cloned. Any existing pointers in
+		the received layout are lost.
+		- Can be redefined in derived classes.
+		*/
+		virtual void r_copy(baseFreeLayout &layout);
+
+		/*
+		- Returns a pointer to the element in the layout (or in a sublayout)
+		with the given id.
+		- If no element with that id is found, the return value is 0.
+		- Can be redefined in derived classes.
+		*/
+		virtual baseElement* find_element(long long elementId);
+
+		/*
+		- Returns a pointer to the element in the layout (or in a sublayout)
+		with the given name.
+		- If no element with that name is found, the return value is 0.
+		- Elements are found through an index kept by the layout, so the
+		elements in it aren't visited.
+		- Can be redefined in derived classes.
+		*/
+		virtual baseElement* find_element(const std::string &elementName);
+
+		/*
+		- Same as 'find_element(elementName)', taking a null-terminated string.
+		*/
+		baseElement* find_element(const char *elementName);
+
+#ifdef LAYOUT_STRING_VIEW
+		/*
+		- Same as 'find_element(elementName)', taking a string view.
+		*/
+		baseElement* find_element(std::string_view elementName);
+#endif
+		
+		/*
+		- Adds a given element to the layout at the lowest free slot.
+		- If the slot is full, the old element is removed (but not deleted).
+		- If the element already has a parent layout, nothing happens.
+		- Can be redefined in derived classes.
+		*/
+		virtual void add_element(baseElement &element);
+		
+		/*
+		- Adds a given element to the layout at the specified slot.
+		- If the slot is full, the old element is removed (but not deleted).
+		- If the element already has a parent layout, nothing happens.
+		- Can be redefined in derived classes.
+		*/
+		virtual void add_element(baseElement &element, int slotNumber);
+
+		/*
+		- Adds the given elements to the layout at the lowest free slots, as
+		many calls to 'add_element' would.
+		- An elastic layout grows only once, and slots are recalculated only
+		once after adding all the elements.
+		- Null elements and elements which already have a parent layout are
+		skipped.
+		*/
+		void add_elements(const std::vector<baseElement*> &newElements);
+
+		/*
+		- Adds the given elements to the layout at consecutive slots from the
+		specified one, removing the old elements (but not deleting them).
+		- Elements that don't fit in a non-elastic layout aren't added.
+		- Otherwise, the same as 'add_elements(newElements)'.
+		*/
+		void add_elements(const std::vector<baseElement*> &newElements,
+			int slotNumber);
+
+		/*
+		- Reserves memory for the given number of slots, so an elastic layout
+		can grow up to it without reallocating.
+		- The size of the layout doesn't change.
+		*/
+		void reserve(int size);
+		
+		/*
+		- Removes an element from the layout at the given slot and returns it.
+		- This doesn't delete the element, just the layout's pointer to it.
+		- Returns 0 if the slot is invalid, or if it's empty.
+		- Can be redefined in derived classes.
+		*/
+		virtual baseElement* remove_element(int slotNumber);
+
+		/*
+		- Removes an element from the layout (or from a sublayout), if present.
+		- Can be redefined in derived classes.
+		*/
+		virtual void remove_element(baseElement &element);
+		
+		/*
+		- Recursively deletes the layout and every element inside it.
+		*/
+		void r_delete();
+
+		/*
+		- Recursively adds the layout and every element inside it to the given
+		geometry store.
+		- Elements added to the layout afterwards are added to the layout's
+		store too, unless they're already in one.
+		*/
+		void r_set_geometry_store(geometryStore &store);
+
+		/*
+		- Methods 'set_depth' and 'set_visibility' from 'baseElement' need to
+		mark the attribute 'drawOrderDirty'.
+		*/
+		friend class baseElement;
+
+		/*
+		- Layout iterators read the attribute 'elements' directly, to avoid
+		copying it.
+		*/
+		friend class layoutIterator;
+	};
+
+
+	/*
+	- Keeps an update scope open on a layout for as long as it exists.
+	- It calls 'begin_update' on construction and 'end_update' on destruction,
+	so the scope is closed even if the code using it returns early.
+	*/
+	class updateScope
+	{
+	private:
+
+		/*
+		- The layout on which the scope is open.
+		*/
+		baseFreeLayout *layout;
+
+		/*
+		- Copying is disabled, as it would close the scope twice.
+		*/
+		updateScope(updateScope &scope);
+		updateScope& operator=(updateScope &scope);
+
+	public:
+
+		/*
+		- Default constructor.
+		- Opens an update scope on the given layout.
+		*/
+		updateScope(baseFreeLayout &layout);
+
+		/*
+		- Default destructor.
+		- Closes the update scope.
+		*/
+		~updateScope();
+	};
+
+
+	/*
+	- A pool of worker threads that run tasks, used by 'baseFreeLayout' to
+	update independent parts of a layout in parallel.
+	- Each thread has its own queue of tasks. Threads take tasks from the back
+	of their own queue and, when it's empty, steal them from the front of the
+	others', so work spreads by itself to idle threads.
+	- Queue 0 belongs to the thread using the pool, which runs tasks too while
+	it waits for them to finish. Only one thread outside the pool may use it
+	at a time.
+	*/
+	class threadPool
+	{
+	public:
+
+		/*
+		- Function run by a task. It receives the task's argument, and the
+		queue of the thread running it, where any tasks it submits must go.
+		*/
+		typedef void (*taskFunction)(void *argument, int queue);
+
+		/*
+		- Number of unfinished tasks of a group, which 'wait' waits for.
+		*/
+		typedef std::atomic<int> taskCounter;
+
+	protected:
+
+		/*
+		- A function to run, its argument, and the counter of the group it
+		belongs to.
+		*/
+		struct task
+		{
+			taskFunction function;
+			void *argument;
+			taskCounter *counter;
+		};
+
+		/*
+		- The tasks submitted by a thread that haven't been taken yet.
+		*/
+		struct taskQueue
+		{
+			std::mutex mutex;
+			std::deque<task> tasks;
+		};
+
+		/*
+		- One queue per thread. Queue 0 belongs to the thread using the pool,
+		and queue 'i' to the worker 'threads[i - 1]'.
+		*/
+		std::vector<taskQueue*> queues;
+
+		/*
+		- The worker threads.
+		*/
+		std::vector<std::thread> threads;
+
+		/*
+		- Number of tasks in all queues.
+		*/
+		std::atomic<int> queuedTasks;
+
+		/*
+		- Guards 'stopping', and lets idle workers sleep on 'wakeUp'.
+		*/
+		std::mutex sleepMutex;
+
+		/*
+		- Wakes up idle workers when tasks are submitted, or when the pool is
+		destroyed.
+		*/
+		std::condition_variable wakeUp;
+
+		/*
+		- Wakes up threads in 'wait' when tasks are submitted, or when the
+		counter of a group of tasks reaches 0.
+		*/
+		std::condition_variable groupDone;
+
+		/*
+		- Set when the pool is destroyed, for the workers to finish.
+		*/
+		bool stopping;
+
+		/*
+		- Takes a task from the back of the given queue or, if it's empty, from
+		the front of another one.
+		- Returns 'false' if all queues are empty.
+		*/
+		bool takeTask(int queue, task &found);
+
+		/*
+		- Runs a task from the given queue's thread and counts it as finished,
+		waking up the threads waiting for its group if it was the last one.
+		*/
+		void runTask(task &found, int queue);
+
+		/*
+		- Main loop of the worker owning the given queue.
+		*/
+		void work(int queue);
+
+		/*
+		- Copying is disabled, as threads can't be copied.
+		*/
+		threadPool(threadPool &pool);
+		threadPool& operator=(threadPool &pool);
+
+	public:
+
+		/*
+		- Default constructor.
+		- Creates a pool where the given number of threads (the one using it
+		included) run tasks. If it's 0 or less, there will be as many threads
+		as hardware threads.
+		*/
+		threadPool(int numberOfThreads = 0);
+
+		/*
+		- Default destructor.
+		- Waits for the workers to finish their current task. Tasks still in
+		the queues aren't run.
+		*/
+		~threadPool();
+
+		/*
+		- Returns the number of threads running tasks, the one using the pool
+		included.
+		*/
+		int get_number_of_threads();
+
+		/*
+		- Adds a task to the given queue. The counter must already count it,
+		and is decreased when the task finishes.
+		*/
+		void submit(taskFunction function, void *argument, taskCounter &counter,
+			int queue = 0);
+
+		/*
+		- Runs tasks from the given queue (or stolen from others) until the
+		counter reaches 0.
+		- While there are no tasks left to take, the thread sleeps until the
+		counter reaches 0 or a task is submitted.
+		*/
+		void wait(taskCounter &counter, int queue = 0);
+	};
+
+
+	/*
+	- Visits every element in a layout (the layout itself included), without
+	recursion: the layouts it's inside of are kept in an explicit stack, so
+	deep layouts can't overflow the call stack.
+	- Elements mustn't be added to or removed from the layouts being visited,
+	except for the element being visited in post-order, which may be deleted
+	(its layout still visits the rest of its slots).
+	*/
+	class layoutIterator
+	{
+	protected:
+
+		/*
+		- A layout being visited, and the position of the next element to visit
+		in it.
+		*/
+		struct frame
+		{
+			baseFreeLayout *layout;
+			int index;
+		};
+
+		/*
+		- Layouts containing the current element, from the outermost one.
+		*/
+		std::vector<frame> frames;
+
+		/*
+		- Element being visited, or 0 once the traversal is done.
+		*/
+		baseElement *current;
+
+		/*
+		- Order in which elements are visited.
+		*/
+		TRAVERSAL order;
+
+		/*
+		- A 'false' value prevents the traversal from entering the current
+		element, if it's a layout. Reset on every step.
+		*/
+		bool descend;
+
+		/*
+		- Returns the next element to visit in the given layout, or 0 if there
+		are no more.
+		*/
+		baseElement* nextChild(frame &layoutFrame);
+
+		/*
+		- Goes down from the current element to the first element to visit in
+		post-order inside it (itself, if it isn't a non-empty layout).
+		*/
+		void descendPostorder();
+
+	public:
+
+		/*
+		- Default constructor.
+		- The first element visited is the received one in pre-order and depth
+		order, and the first element inside it with no elements in post-order.
+		*/
+		layoutIterator(baseElement &root, TRAVERSAL order = preorder);
+
+		/*
+		- Default destructor.
+		*/
+		~layoutIterator();
+
+		/*
+		- Returns a pointer to the element being visited, or 0 once the
+		traversal is done.
+		*/
+		baseElement* get_element();
+
+		/*
+		- Returns the number of layouts between the element being visited and
+		the element where the traversal started (0 for that element).
+		*/
+		int get_level();
+
+		/*
+		- Returns 'true' once every element has been visited.
+		*/
+		bool is_done();
+
+		/*
+		- Moves on to the next element.
+		*/
+		void next();
+
+		/*
+		- Prevents the traversal from entering the element being visited, if it's
+		a layout. Has no effect in post-order, where elements inside are visited
+		first.
+		*/
+		void skip_children();
+
+		/*
+		- Returns the element being visited. The traversal MUSTN'T be done.
+		*/
+		baseElement& operator*();
+
+		/*
+		- Returns a pointer to the element being visited.
+		*/
+		baseElement* operator->();
+
+		/*
+		- Same as 'next'.
+		*/
+		layoutIterator& operator++();
+	};
+
+
+	/*
+	- Receives every element reached by 'baseFreeLayout::traverse'.
+	- This class shouldn't be instanced, but serve as a base for other classes.
+	*/
+	class layoutVisitor
+	{
+	public:
+
+		/*
+		- Default destructor.
+		*/
+		virtual ~layoutVisitor();
+
+		/*
+		- Called for every element reached by a traversal, in its order.
+		- Returning 'false' stops the traversal.
+		- MUST be defined in instantiable derived classes.
+		*/
+		virtual bool visit(baseElement &element) = 0;
+	};
+
+
+	/*
+	- A layout (a series of slots where elements can be allocated).
+	- Elements in an horizontal layout are drawn from left to right.
+	- Slots are assigned an equal share of horizontal space, and full vertical
+	space (relative to the layout content's height and width).
+	- By default, newly added elements change their alignment to top-left.
+	- This class shouldn't be instanced, but serve as a base for other classes.
+	*/
+	class baseHorizontalLayout : public virtual baseFreeLayout
+	{
+	protected:
+
+		/*
+		- Recalculates the position and size of an element's slot given its
+		position inside the 'elements' vector.
+		*/
+		void recalculateSlotBounds(baseElement &element);
+
+		/*
+		- Calculates the position and size of every slot in the layout at once.
+		*/
+		bool calculateSlotRects(float *slotPosX, float *slotPosY,
+			float *slotWidth, float *slotHeight);
+
+		/*
+		- Returns 'false': slots share the width of the layout, so they depend
+		on its size.
+		*/
+		bool supportsSparseSlots();
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		baseHorizontalLayout();
+
+		/*
+		- Default destructor.
+		*/
+		virtual ~baseHorizontalLayout();
+	};
+
+	
+	/*
+	- A layout (a series of slots where elements can be allocated).
+	- Elements in a vertical layout are drawn from top to bottom.
+	- Slots are assigned an equal share of vertical space, and full horizontal
+	space (relative to the layout content's width and height).
+	- By default, newly added elements change their alignment to top-left.
+	- This class shouldn't be instanced, but serve as a base for other classes.
+	*/
+	class baseVerticalLayout : public virtual baseFreeLayout
+	{
+	protected:
+
+		/*
+		- Recalculates the position and size of an element's slot given its
+		position inside the 'elements' vector.
+		*/
+		void recalculateSlotBounds(baseElement &element);
+
+		/*
+		- Calculates the position and size of every slot in the layout at once.
+		*/
+		bool calculateSlotRects(float *slotPosX, float *slotPosY,
+			float *slotWidth, float *slotHeight);
+
+		/*
+		- Returns 'false': slots share the height of the layout, so they depend
+		on its size.
+		*/
+		bool supportsSparseSlots();
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		baseVerticalLayout();
+
+		/*
+		- Default destructor.
+		*/
+		virtual ~baseVerticalLayout();
+	};
+
+
+	/*
+	- A layout (a series of slots where elements can be allocated).
+	- Elements in a table layout are positioned from left to right until a row
+	is full, then start a new row from top to bottom.
+	- The width of the layout's content is distributed equally between the slots
+	in each row, so does its height with the slots in each column.
+	- By default, newly added elements change their alignment to top-left.
+	- A table layout can't be elastic.
+	- Virtualized tables (see 'set_virtualization') work differently: cells
+	have a fixed size and the content frame shows the part of the grid given
+	by the scroll offset. Only the cells in view (plus a few on each side, see
+	'overscan') are kept, as elements cloned from a prototype and bound to a
+	row and a column each by a user function. Cells are recycled as the table
+	scrolls, so the number of elements depends on the size of the layout, not
+	on the size of the grid. Cells can't be added or removed by hand, and those
+	in the layout when it's destroyed must be deleted like any other element.
+	- This class shouldn't be instanced, but serve as a base for other classes.
+	*/
+	class baseTableLayout : public virtual baseFreeLayout
+	{
+	private:
+
+		/*
+		- The method for turning on elasticity is hidden.
+		*/
+		using baseFreeLayout::set_elasticity;
+
+	public:
+
+		/*
+		- Functions binding a cell of a virtualized table to a row and a column.
+		They receive the cell, the row, the column and the data given along with
+		the function.
+		*/
+		typedef void (*bindFunction)(baseElement &cell, int row, int column,
+			void *data);
+
+	protected:
+
+		/*
+		- The number of rows between which the content height will be divided
+		(also the number of slots per column).
+		- Can't be negative.
+		*/
+		int numberOfRows;
+
+		/*
+		- The number of columns between which the content width will be divided
+		(also the number of slots per row).
+		- Can't be negative.
+		*/
+		int numberOfColumns;
+
+		/*
+		- 'true' if the table is virtualized (see the class description).
+		*/
+		bool virtualized;
+
+		/*
+		- The size of every cell of a virtualized table.
+		- No cells are created unless both are greater than 0.
+		*/
+		float cellWidth, cellHeight;
+
+		/*
+		- The distance a virtualized table has been scrolled, from the top-left
+		corner of the grid to that of the content frame.
+		- Between 0 and 'get_max_scroll_offset_x()' or
+		'get_max_scroll_offset_y()'.
+		*/
+		double scrollOffsetX, scrollOffsetY;
+
+		/*
+		- The number of rows and columns out of view that are kept bound on each
+		side of a virtualized table.
+		- Can't be negative.
+		*/
+		int overscan;
+
+		/*
+		- The first row and column shown by cells of a virtualized table.
+		*/
+		int firstRow, firstColumn;
+
+		/*
+		- The row bound to each row of cells of a virtualized table, or -1 if
+		none.
+		- Cells are kept in rows of 'boundColumns.size()' slots. Row 'r' of the
+		grid is always shown by row 'r % boundRows.size()' of cells.
+		*/
+		std::vector<int> boundRows;
+
+		/*
+		- The column bound to each column of cells of a virtualized table, or -1
+		if none.
+		- Column 'c' of the grid is always shown by column
+		'c % boundColumns.size()' of cells.
+		*/
+		std::vector<int> boundColumns;
+
+		/*
+		- The element cells are cloned (recursively) from, or 0 if none.
+		- Not owned by the layout.
+		*/
+		baseElement *cellPrototype;
+
+		/*
+		- The function binding cells to rows and columns, or 0 if none.
+		*/
+		bindFunction bindCell;
+
+		/*
+		- Data given to 'bindCell' along with every cell.
+		*/
+		void *bindData;
+
+		/*
+		- Returns the number of rows or columns of cells a virtualized table
+		needs on an axis, given the number of rows or columns in the grid, the
+		size of the content frame and the size of cells on that axis.
+		*/
+		int getPoolLength(int count, float viewport, float cellSize);
+
+		/*
+		- Returns the first row or column shown by cells on an axis, given the
+		scroll offset, the size of cells, the number of rows or columns in the
+		grid and the number of rows or columns of cells on that axis.
+		*/
+		int getFirstShown(double scrollOffset, float cellSize, int count,
+			int poolLength);
+
+		/*
+		- Creates a new cell by cloning the prototype.
+		- Can be redefined in derived classes.
+		*/
+		virtual baseElement* createCell();
+
+		/*
+		- Resizes the pool of cells of a virtualized table to fit the content
+		frame, clamps the scroll offset and binds the cells whose row or column
+		have changed (or every cell, if 'rebindAll' is 'true'). Slots are marked
+		for recalculation.
+		*/
+		void updateCells(bool rebindAll);
+
+		/*
+		- Recalculates the position and size of an element's slot given its
+		position inside the 'elements' vector (or, if virtualized, the row and
+		column bound to it).
+		*/
+		void recalculateSlotBounds(baseElement &element);
+
+		/*
+		- Calculates the position and size of every slot in the layout at once.
+		*/
+		bool calculateSlotRects(float *slotPosX, float *slotPosY,
+			float *slotWidth, float *slotHeight);
+
+		/*
+		- Returns 'false': slots depend on the number of rows and columns.
+		*/
+		bool supportsSparseSlots();
+
+	public:
+
+		/*
+		- Default constructor.
+		*/
+		baseTableLayout(int numberOfRows = 0, int numberOfColumns = 0);
+
+		/*
+		- Default destructor.
+		*/
+		virtual ~baseTableLayout();
+
+		/*
+		- Returns the value of the attribute 'numberOfRows'.
+		*/
+		int get_number_of_rows();
+
+		/*
+		- Returns the value of the attribute 'numberOfColumns'.
+		*/
+		int get_number_of_columns();
+
+		/*
+		- For the original overload of 'is_slot_full'.
+		*/
+		using baseFreeLayout::is_slot_full;
+
+		/*
+		- Returns the value of the attribute 'virtualized'.
+		*/
+		bool get_virtualization();
+
+		/*
+		- Returns the value of the attribute 'cellWidth'.
+		*/
+		float get_cell_width();
+
+		/*
+		- Returns the value of the attribute 'cellHeight'.
+		*/
+		float get_cell_height();
+
+		/*
+		- Returns the value of the attribute 'scrollOffsetX'.
+		*/
+		double get_scroll_offset_x();
+
+		/*
+		- Returns the value of the attribute 'scrollOffsetY'.
+		*/
+		double get_scroll_offset_y();
+
+		/*
+		- Returns the greatest horizontal scroll offset of a virtualized table,
+		at which the last column is at the right of the content frame (0 if all
+		columns fit in it).
+		*/
+		double get_max_scroll_offset_x();
+
+		/*
+		- Returns the greatest vertical scroll offset of a virtualized table, at
+		which the last row is at the bottom of the content frame (0 if all rows
+		fit in it).
+		*/
+		double get_max_scroll_offset_y();
+
+		/*
+		- Returns the value of the attribute 'overscan'.
+		*/
+		int get_overscan();
+
+		/*
+		- Returns the value of the attribute 'firstRow'.
+		*/
+		int get_first_row();
+
+		/*
+		- Returns the value of the attribute 'firstColumn'.
+		*/
+		int get_first_column();
+
+		/*
+		- Returns the value of the attribute 'cellPrototype'.
+		*/
+		baseElement* get_cell_prototype();
+
+		/*
+		- Calls 'is_slot_full' translating row and column to slot number.
+		- If virtualized, returns 'true' if a cell is bound to the row and
+		column.
+		*/
+		bool is_slot_full(int row, int column);
+		
+		/*
+		- For the original overload of 'get_element'.
+		*/
+		using baseFreeLayout::get_element;
+
+		/*
+		- Calls 'get_element' translating row and column to slot number.
+		- If virtualized, returns the cell bound to the row and column, or 0 if
+		there's none.
+		- Can be redefined in derived classes.
+		*/
+		virtual baseElement* get_element(int row, int column);
+
+		/*
+		- Sets the attribute 'numberOfRows'.
+		- If the value changes, position and size of slots inside the layout are
+		marked for recalculation.
+		*/
+		void set_number_of_rows(int numberOfRows);
+
+		/*
+		- Sets the attribute 'numberOfColumns'.
+		- If the value changes, position and size of slots inside the layout are
+		marked for recalculation.
+		*/
+		void set_number_of_columns(int numberOfColumns);
+
+		/*
+		- Sets the attributes 'numberOfRows' and 'numberOfColumns'.
+		- If one or both values change, position and size of slots inside the
+		layout are marked for recalculation.
+		- Hides the method 'set_size(int size)' from 'freeLayout'.
+		*/
+		void set_size(int numberOfRows, int numberOfColumns);
+
+		/*
+		- Sets the attribute 'virtualized'.
+		- Elements in the layout are removed from it. Those that were cells of a
+		virtualized table are deleted.
+		*/
+		void set_virtualization(bool virtualized);
+
+		/*
+		- Sets the attributes 'cellWidth' and 'cellHeight'.
+		*/
+		void set_cell_size(float cellWidth, float cellHeight);
+
+		/*
+		- Sets the attributes 'scrollOffsetX' and 'scrollOffsetY' (clamped to
+		their valid ranges), and binds the cells whose row or column changes.
+		*/
+		void set_scroll_offset(double scrollOffsetX, double scrollOffsetY);
+
 		/*
-		- Sets the attribute 'elastic'.
+		- Sets the attribute 'overscan'.
 		*/
-		void set_elasticity(bool elasticity);
+		void set_overscan(int overscan);
 
 		/*
-		- Recursively changes content position and size of every element inside
-		the layout, so they exactly match those of their slot.
+		- Sets the attribute 'cellPrototype'. Existing cells are deleted and
+		cloned again from it.
 		*/
-		void r_match_content_to_slot();
+		void set_cell_prototype(baseElement &cellPrototype);
 
 		/*
-		- Recursively changes slot position and size of every element inside
-		the layout, so they exactly match those of their slot.
+		- Sets the attributes 'bindCell' and 'bindData', and binds every cell
+		again.
 		*/
-		void r_match_slot_to_content();
+		void set_bind_function(bindFunction bindCell, void *bindData = 0);
 
 		/*
-		- Recursively aligns the layout and every element inside it in
-		accordance to their attributes.
+		- Binds every cell of a virtualized table again (e.g. after the data
+		shown has changed).
 		*/
-		void r_align();
+		void refresh_cells();
 
 		/*
-		- Recursively aligns the layout and every element inside it in
-		accordance to the parameters.
+		- Sets the content size, like in 'baseFreeLayout'. A virtualized table
+		also resizes its pool of cells to fit it.
 		*/
-		void r_align(ALIGNMENT alignmentX, ALIGNMENT alignmentY);
-		
+		void set_content_size(float contentWidth, float contentHeight);
+
 		/*
 		- Copies the current layout's attributes into the received one.
 		- Elements inside are not copied (the layout keeps its elements if any).
 		- Can be redefined in derived classes.
 		*/
-		virtual void copy(baseFreeLayout &layout);
+		virtual void copy(baseTableLayout &layout);
 		
 		/*
 		- Copies the current layout's attributes into the received one.
@@ -949,267 +3926,310 @@ namespace LAYOUT
 		the received layout are lost.
 		- Can be redefined in derived classes.
 		*/
-		virtual void r_copy(baseFreeLayout &layout);
+		virtual void r_copy(baseTableLayout &layout);
 
 		/*
-		- Returns a pointer to the element in the layout (or in a sublayout)
-		with the given id.
-		- If no element with that id is found, the return value is 0.
-		- Can be redefined in derived classes.
+		- For the original overloads of 'add_element'.
 		*/
-		virtual baseElement* find_element(int elementId);
+		using baseFreeLayout::add_element;
 
 		/*
-		- Returns a pointer to the element in the layout (or in a sublayout)
-		with the given name.
-		- If no element with that name is found, the return value is 0.
+		- Calls 'add_element' translating row and column to slot number.
+		- Does nothing if the table is virtualized.
 		- Can be redefined in derived classes.
 		*/
-		virtual baseElement* find_element(std::string elementName);
-		
+		virtual void add_element(baseElement &element, int row, int column);
+
 		/*
-		- Adds a given element to the layout at the lowest free slot.
-		- If the slot is full, the old element is removed (but not deleted).
-		- If the element already has a parent layout, nothing happens.
-		- Can be redefined in derived classes.
+		- For the original overloads of 'add_elements'.
 		*/
-		virtual void add_element(baseElement &element);
-		
+		using baseFreeLayout::add_elements;
+
 		/*
-		- Adds a given element to the layout at the specified slot.
-		- If the slot is full, the old element is removed (but not deleted).
-		- If the element already has a parent layout, nothing happens.
-		- Can be redefined in derived classes.
+		- Calls 'add_elements' translating row and column to slot number, so
+		the elements fill the rest of that row and the following ones.
+		- Does nothing if the table is virtualized.
 		*/
-		virtual void add_element(baseElement &element, int slotNumber);
-		
+		void add_elements(const std::vector<baseElement*> &newElements, int row,
+			int column);
+
 		/*
-		- Removes an element from the layout at the given slot and returns it.
-		- This doesn't delete the element, just the layout's pointer to it.
-		- Returns 0 if the slot is invalid, or if it's empty.
-		- Can be redefined in derived classes.
+		- For the original overload of 'remove_element'.
 		*/
-		virtual baseElement* remove_element(int slotNumber);
+		using baseFreeLayout::remove_element;
 
 		/*
-		- Removes an element from the layout (or from a sublayout), if present.
+		- Calls 'remove_element' translating row and column to slot number.
+		- Does nothing (and returns 0) if the table is virtualized.
 		- Can be redefined in derived classes.
 		*/
-		virtual void remove_element(baseElement &element);
-		
-		/*
-		- Recursively deletes the layout and every element inside it.
-		*/
-		void r_delete();
+		virtual baseElement* remove_element(int row, int column);
 	};
 
 
 	/*
-	- A layout (a series of slots where elements can be allocated).
-	- Elements in an horizontal layout are drawn from left to right.
-	- Slots are assigned an equal share of horizontal space, and full vertical
-	space (relative to the layout content's height and width).
-	- By default, newly added elements change their alignment to top-left.
+	- A layout showing a long list of items (from top to bottom, or from left
+	to right if horizontal), all of them the same size on the list's axis and
+	as wide (or as tall) as the layout's content.
+	- Items aren't elements. Only those in view (plus a few on each side, see
+	'overscan') are shown, by rows: elements cloned from a prototype and bound
+	to an item each by a user function. Rows are recycled as the list scrolls,
+	and only those bound to a new item are bound again.
+	- Item 'i' is always shown by the row in slot 'i % poolSize', so the number
+	of rows (and the cost of updating and drawing the list) depends on the size
+	of the layout, not on the number of items.
+	- Rows are created and deleted by the layout as needed. Those in it when
+	it's destroyed must be deleted like any other element (e.g. by 'r_delete').
+	Elements mustn't be added to or removed from the layout otherwise.
+	- Rows entirely out of view are made not visible.
 	- This class shouldn't be instanced, but serve as a base for other classes.
 	*/
-	class baseHorizontalLayout : public virtual baseFreeLayout
+	class baseListLayout : public virtual baseFreeLayout
 	{
-	protected:
+	private:
 
 		/*
-		- Recalculates the position and size of an element's slot given its
-		position inside the 'elements' vector.
+		- The methods for turning on elasticity and resizing are hidden, as the
+		layout manages its own size.
 		*/
-		void recalculateSlotBounds(baseElement &element);
+		using baseFreeLayout::set_elasticity;
+		using baseFreeLayout::set_size;
 
 	public:
 
 		/*
-		- Default constructor.
+		- Functions binding a row to an item. They receive the row, the index of
+		the item and the data given along with the function.
 		*/
-		baseHorizontalLayout();
+		typedef void (*bindFunction)(baseElement &row, int item, void *data);
+
+	protected:
 
 		/*
-		- Default destructor.
+		- 'true' if items are laid out from left to right, 'false' if from top
+		to bottom.
 		*/
-		virtual ~baseHorizontalLayout();
-	};
+		bool horizontal;
 
-	
-	/*
-	- A layout (a series of slots where elements can be allocated).
-	- Elements in a vertical layout are drawn from top to bottom.
-	- Slots are assigned an equal share of vertical space, and full horizontal
-	space (relative to the layout content's width and height).
-	- By default, newly added elements change their alignment to top-left.
-	- This class shouldn't be instanced, but serve as a base for other classes.
-	*/
-	class baseVerticalLayout : public virtual baseFreeLayout
-	{
-	protected:
+		/*
+		- The number of items in the list.
+		- Can't be negative.
+		*/
+		int itemCount;
 
 		/*
-		- Recalculates the position and size of an element's slot given its
-		position inside the 'elements' vector.
+		- The size of every item on the list's axis (height if vertical, width
+		if horizontal).
+		- No rows are created unless it's greater than 0.
 		*/
-		void recalculateSlotBounds(baseElement &element);
+		float itemExtent;
 
-	public:
+		/*
+		- The distance the list has been scrolled, from the start of the first
+		item to the start of the content frame.
+		- Between 0 and 'get_max_scroll_offset()'. It's a 'double' so that
+		positions stay exact in very long lists.
+		*/
+		double scrollOffset;
 
 		/*
-		- Default constructor.
+		- The number of items out of view that are kept bound on each side, so
+		scrolling a little doesn't bind any row.
+		- Can't be negative.
 		*/
-		baseVerticalLayout();
+		int overscan;
 
 		/*
-		- Default destructor.
+		- The first item shown by a row.
 		*/
-		virtual ~baseVerticalLayout();
-	};
+		int firstItem;
 
+		/*
+		- The element rows are cloned (recursively) from, or 0 if none.
+		- Not owned by the layout.
+		*/
+		baseElement *rowPrototype;
 
-	/*
-	- A layout (a series of slots where elements can be allocated).
-	- Elements in a table layout are positioned from left to right until a row
-	is full, then start a new row from top to bottom.
-	- The width of the layout's content is distributed equally between the slots
-	in each row, so does its height with the slots in each column.
-	- By default, newly added elements change their alignment to top-left.
-	- A table layout can't be elastic.
-	- This class shouldn't be instanced, but serve as a base for other classes.
-	*/
-	class baseTableLayout : public virtual baseFreeLayout
-	{
-	private:
+		/*
+		- The function binding rows to items, or 0 if none.
+		*/
+		bindFunction bindRow;
 
 		/*
-		- The method for turning on elasticity is hidden.
+		- Data given to 'bindRow' along with every row.
 		*/
-		using baseFreeLayout::set_elasticity;
+		void *bindData;
 
-	protected:
+		/*
+		- The item bound to each row, by slot, or -1 if none.
+		*/
+		std::vector<int> boundItems;
 
 		/*
-		- The number of rows between which the content height will be divided
-		(also the number of slots per column).
-		- Can't be negative.
+		- Returns the size of the content frame on the list's axis.
 		*/
-		int numberOfRows;
+		float getViewportExtent();
 
 		/*
-		- The number of columns between which the content width will be divided
-		(also the number of slots per row).
-		- Can't be negative.
+		- Creates a new row by cloning the prototype.
+		- Can be redefined in derived classes.
 		*/
-		int numberOfColumns;
+		virtual baseElement* createRow();
 
 		/*
-		- Recalculates the position and size of an element's slot given its
-		position inside the 'elements' vector.
+		- Resizes the pool of rows to fit the content frame, clamps the scroll
+		offset and binds the rows whose item has changed (or every row, if
+		'rebindAll' is 'true'). Slots are marked for recalculation.
+		*/
+		void updateRows(bool rebindAll);
+
+		/*
+		- Calculates the slot of the row bound to the given item (or an empty
+		slot at the start of the content frame, if the item is -1).
+		*/
+		void calculateItemSlot(int item, float &slotPosX, float &slotPosY,
+			float &slotWidth, float &slotHeight);
+
+		/*
+		- Recalculates the position and size of a row's slot given the item
+		bound to it.
 		*/
 		void recalculateSlotBounds(baseElement &element);
 
+		/*
+		- Calculates the position and size of every row's slot at once.
+		*/
+		bool calculateSlotRects(float *slotPosX, float *slotPosY,
+			float *slotWidth, float *slotHeight);
+
+		/*
+		- Returns 'false': slots are a pool of rows bound to items.
+		*/
+		bool supportsSparseSlots();
+
 	public:
 
 		/*
 		- Default constructor.
 		*/
-		baseTableLayout(int numberOfRows = 0, int numberOfColumns = 0);
+		baseListLayout(bool horizontal = false, int itemCount = 0,
+			float itemExtent = 0);
 
 		/*
 		- Default destructor.
+		- Rows are not deleted (see the class description).
 		*/
-		virtual ~baseTableLayout();
+		virtual ~baseListLayout();
 
 		/*
-		- Returns the value of the attribute 'numberOfRows'.
+		- Returns the value of the attribute 'horizontal'.
 		*/
-		int get_number_of_rows();
+		bool is_horizontal();
 
 		/*
-		- Returns the value of the attribute 'numberOfColumns'.
+		- Returns the value of the attribute 'itemCount'.
 		*/
-		int get_number_of_columns();
+		int get_item_count();
 
 		/*
-		- For the original overload of 'is_slot_full'.
+		- Returns the value of the attribute 'itemExtent'.
 		*/
-		using baseFreeLayout::is_slot_full;
+		float get_item_extent();
 
 		/*
-		- Calls 'is_slot_full' translating row and column to slot number.
+		- Returns the value of the attribute 'scrollOffset'.
 		*/
-		bool is_slot_full(int row, int column);
-		
+		double get_scroll_offset();
+
 		/*
-		- For the original overload of 'get_element'.
+		- Returns the greatest scroll offset, at which the last item is at the
+		end of the content frame (0 if all items fit in it).
 		*/
-		using baseFreeLayout::get_element;
+		double get_max_scroll_offset();
 
 		/*
-		- Calls 'get_element' translating row and column to slot number.
+		- Returns the value of the attribute 'overscan'.
+		*/
+		int get_overscan();
+
+		/*
+		- Returns the value of the attribute 'firstItem'.
+		*/
+		int get_first_item();
+
+		/*
+		- Returns the value of the attribute 'rowPrototype'.
+		*/
+		baseElement* get_row_prototype();
+
+		/*
+		- Returns a pointer to the row bound to the given item, or 0 if the item
+		isn't bound to any.
 		- Can be redefined in derived classes.
 		*/
-		virtual baseElement* get_element(int row, int column);
+		virtual baseElement* get_row(int item);
 
 		/*
-		- Sets the attribute 'numberOfRows'.
-		- If the value changes, position and size of slots inside the layout are
-		recalculated.
+		- Sets the attribute 'itemCount'. Rows are only bound again if their
+		item changes (see 'refresh_items').
 		*/
-		void set_number_of_rows(int numberOfRows);
+		void set_item_count(int itemCount);
 
 		/*
-		- Sets the attribute 'numberOfColumns'.
-		- If the value changes, position and size of slots inside the layout are
-		recalculated.
+		- Sets the attribute 'itemExtent'.
 		*/
-		void set_number_of_columns(int numberOfColumns);
+		void set_item_extent(float itemExtent);
 
 		/*
-		- Sets the attributes 'numberOfRows' and 'numberOfColumns'.
-		- If one or both values change, position and size of slots inside the
-		layout are recalculated.
-		- Hides the method 'set_size(int size)' from 'freeLayout'.
+		- Sets the attribute 'scrollOffset' (clamped to its valid range), and
+		binds the rows whose item changes.
 		*/
-		void set_size(int numberOfRows, int numberOfColumns);
+		void set_scroll_offset(double scrollOffset);
 
 		/*
-		- Copies the current layout's attributes into the received one.
-		- Elements inside are not copied (the layout keeps its elements if any).
-		- Can be redefined in derived classes.
+		- Sets the attribute 'overscan'.
 		*/
-		virtual void copy(baseTableLayout &layout);
-		
+		void set_overscan(int overscan);
+
 		/*
-		- Copies the current layout's attributes into the received one.
-		- Elements inside are also recursively cloned. Any existing pointers in
-		the received layout are lost.
-		- Can be redefined in derived classes.
+		- Sets the attribute 'rowPrototype'. Existing rows are deleted and
+		cloned again from it.
 		*/
-		virtual void r_copy(baseTableLayout &layout);
+		void set_row_prototype(baseElement &rowPrototype);
 
 		/*
-		- For the original overloads of 'add_element'.
+		- Sets the attributes 'bindRow' and 'bindData', and binds every row
+		again.
 		*/
-		using baseFreeLayout::add_element;
+		void set_bind_function(bindFunction bindRow, void *bindData = 0);
 
 		/*
-		- Calls 'add_element' translating row and column to slot number.
-		- Can be redefined in derived classes.
+		- Binds every row again (e.g. after the items have changed).
 		*/
-		virtual void add_element(baseElement &element, int row, int column);
+		void refresh_items();
 
 		/*
-		- For the original overload of 'remove_element'.
+		- Sets the content size, like in 'baseFreeLayout', and resizes the pool
+		of rows to fit it.
 		*/
-		using baseFreeLayout::remove_element;
+		void set_content_size(float contentWidth, float contentHeight);
 
 		/*
-		- Calls 'remove_element' translating row and column to slot number.
+		- Copies the current layout's attributes into the received one.
+		- Rows are not copied. Those the received layout has (if any) are
+		considered bound to the same items as the current layout's, and it
+		creates any that are missing the next time the rows are updated.
 		- Can be redefined in derived classes.
 		*/
-		virtual baseElement* remove_element(int row, int column);
+		virtual void copy(baseListLayout &layout);
+
+		/*
+		- Copies the current layout's attributes into the received one.
+		- Rows are also recursively cloned. Any existing pointers in the
+		received layout are lost.
+		- Can be redefined in derived classes.
+		*/
+		virtual void r_copy(baseListLayout &layout);
 	};
 
 
@@ -1225,6 +4245,8 @@ namespace LAYOUT
 
 	/*
 	- Next there are some generic functions commonly used as event conditions.
+	- They can also be used by typed events (see 'typedEvent') with condition
+	arguments of type 'positionArguments' (declared above).
 	*/
 
 	/*
@@ -1234,7 +4256,13 @@ namespace LAYOUT
 		- "posX" (float*): the target position on the X axis.
 		- "posY" (float*): the target position on the Y axis.
 	*/
-	bool position_inside_content_frame(std::map<std::string, void*> &args);
+	bool position_inside_content_frame(const argumentView &args);
+
+	/*
+	- Typed version of 'position_inside_content_frame'.
+	*/
+	bool position_inside_content_frame(baseElement &element,
+		const positionArguments &args);
 
 	/*
 	- Returns true if the given position is within the element's slot frame.
@@ -1243,7 +4271,122 @@ namespace LAYOUT
 		- "posX" (float*): the target position on the X axis.
 		- "posY" (float*): the target position on the Y axis.
 	*/
-	bool position_inside_slot_frame(std::map<std::string, void*> &args);
+	bool position_inside_slot_frame(const argumentView &args);
+
+	/*
+	- Typed version of 'position_inside_slot_frame'.
+	*/
+	bool position_inside_slot_frame(baseElement &element,
+		const positionArguments &args);
+
+
+	/* TEMPLATE IMPLEMENTATIONS */
+
+
+	template <class conditionArgs>
+	void elementHandler::activate_events(const std::string &eventName,
+		const conditionArgs &args)
+	{
+		const void *argumentsType =
+			typedEventBase<conditionArgs>::arguments_type();
+		// As in the untyped version, the list is looked up after every event.
+		long long elementId = -1;
+		while (subscriber *s = nextSubscriber(eventName, elementId))
+		{
+			elementId = s->element->id;
+			if (s->subscribedEvent->argumentsType == argumentsType)
+				static_cast<typedEventBase<conditionArgs>*>(
+				s->subscribedEvent)->activate(*s->element, args);
+		}
+	}
+
+
+	template <class conditionArgs>
+	typedEventBase<conditionArgs>::typedEventBase()
+	{
+		this->argumentsType = arguments_type();
+	}
+
+
+	template <class conditionArgs>
+	const void* typedEventBase<conditionArgs>::arguments_type()
+	{
+		// Every type of arguments gets its own variable, so its address
+		// identifies the type.
+		static const char type = 0;
+		return &type;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	typedEvent<conditionArgs, effectArgs>::typedEvent(
+		typedConditionType typedCondition, typedEffectType typedEffect,
+		const effectArgs &effectArguments)
+	{
+		this->typedCondition = typedCondition;
+		this->typedEffect = typedEffect;
+		this->effectArguments = effectArguments;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	typename typedEvent<conditionArgs, effectArgs>::typedConditionType
+		typedEvent<conditionArgs, effectArgs>::get_event_condition()
+	{
+		return typedCondition;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	typename typedEvent<conditionArgs, effectArgs>::typedEffectType
+		typedEvent<conditionArgs, effectArgs>::get_event_effect()
+	{
+		return typedEffect;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	effectArgs& typedEvent<conditionArgs, effectArgs>::get_effect_args()
+	{
+		return effectArguments;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	void typedEvent<conditionArgs, effectArgs>::set_event_condition(
+		typedConditionType typedCondition)
+	{
+		this->typedCondition = typedCondition;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	void typedEvent<conditionArgs, effectArgs>::set_event_effect(
+		typedEffectType typedEffect)
+	{
+		this->typedEffect = typedEffect;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	void typedEvent<conditionArgs, effectArgs>::set_effect_args(
+		const effectArgs &effectArguments)
+	{
+		this->effectArguments = effectArguments;
+	}
+
+
+	template <class conditionArgs, class effectArgs>
+	bool typedEvent<conditionArgs, effectArgs>::activate(baseElement &element,
+		const conditionArgs &args)
+	{
+		if (typedEffect && (!typedCondition || typedCondition(element, args)))
+		{
+			typedEffect(element, effectArguments);
+			return true;
+		}
+		return false;
+	}
 
 };
 
@@ -0,0 +1,131 @@
+/*
+|------------------------------------------------------------------------------|
+|                          TEST_EVENT_ALLOCATIONS.CPP                          |
+|------------------------------------------------------------------------------|
+| - Checks that activating events whose condition and effect receive an        |
+| 'argumentView' allocates no memory (in particular, builds no maps), whether  |
+| they're activated directly or through an element handler.                    |
+| - Events whose condition and effect receive a map still build it on every    |
+| activation, which is checked too, so that the count is known to work.        |
+| - Returns 0 (and prints "ok") if the test passes.                            |
+|------------------------------------------------------------------------------|
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "SFMLLayout.hpp"
+
+
+/*
+- Number of allocations made so far with 'operator new'.
+*/
+long allocations = 0;
+
+
+/*
+- Replacements for the global allocation functions, counting allocations.
+*/
+void* operator new(std::size_t size)
+{
+	allocations ++;
+	void *memory = malloc(size ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+	free(memory);
+}
+
+
+/*
+- Number of times an effect has been activated.
+*/
+int activations = 0;
+
+
+/*
+- Condition and effect receiving a view of their arguments.
+*/
+bool view_condition(const LAYOUT::argumentView &args)
+{
+	return args.get("posX") && args.get("element");
+}
+
+void view_effect(const LAYOUT::argumentView &args)
+{
+	if (args.get("tag"))
+		activations ++;
+}
+
+
+/*
+- Condition and effect receiving a map of their arguments.
+*/
+bool map_condition(std::map<std::string, void*> &args)
+{
+	return args["posX"] != 0;
+}
+
+void map_effect(std::map<std::string, void*> & /*args*/)
+{
+	activations ++;
+}
+
+
+/*
+- Main function. Runs the test.
+*/
+int main()
+{
+	LAYOUT::elementHandler handler;
+	LAYOUT::spriteElement elements[20];
+	LAYOUT::event viewEvents[20], mapEvent;
+	int tag = 1;
+	for (int i = 0 ; i < 20 ; i ++)
+	{
+		viewEvents[i].set_event_condition(view_condition);
+		viewEvents[i].set_event_effect(view_effect);
+		viewEvents[i].add_default_condition_argument("element",
+			static_cast<LAYOUT::baseElement*>(&elements[i]));
+		viewEvents[i].add_default_effect_argument("tag", &tag);
+		elements[i].add_event("onClick", viewEvents[i]);
+		handler.add_element(elements[i]);
+	}
+	mapEvent.set_event_condition(map_condition);
+	mapEvent.set_event_effect(map_effect);
+
+	// Maps of arguments given on activation are built beforehand.
+	float posX = 0;
+	std::map<std::string, void*> conditionArgs, effectArgs;
+	conditionArgs["posX"] = &posX;
+
+	long before = allocations;
+	for (int i = 0 ; i < 100 ; i ++)
+	{
+		viewEvents[0].activate(conditionArgs, effectArgs);
+		handler.activate_events("onClick", conditionArgs, effectArgs);
+	}
+	long viewAllocations = allocations - before;
+	if (viewAllocations != 0 || activations != 100 * 21)
+	{
+		printf("FAILED: %ld allocations in %d activations with views\n",
+			viewAllocations, activations);
+		return 1;
+	}
+
+	before = allocations;
+	mapEvent.activate(conditionArgs, effectArgs);
+	if (allocations == before)
+	{
+		printf("FAILED: allocations aren't being counted\n");
+		return 1;
+	}
+
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,82 @@
+/*
+|------------------------------------------------------------------------------|
+|                           TEST_GEOMETRY_STORE.CPP                            |
+|------------------------------------------------------------------------------|
+| - Regression test for the tracking of changes in geometry stores.            |
+| - Removing an element from a store moves the last one into its index. The    |
+| changes of the moved element must still reach the snapshots published by a  |
+| 'snapshotBuffer' afterwards.                                                 |
+| - Returns 0 (and prints "ok") if the test passes.                            |
+|------------------------------------------------------------------------------|
+*/
+
+
+#include <cstdio>
+#include "SFMLLayout.hpp"
+
+
+/*
+- Returns 'true' if any record in the snapshot has the given content position.
+*/
+bool has_content_at(const LAYOUT::layoutSnapshot &snapshot, float posX,
+	float posY)
+{
+	const std::vector<LAYOUT::snapshotRecord> &records =
+		snapshot.get_records();
+	for (int i = 0 ; i < records.size() ; i ++)
+		if (records[i].contentPosX == posX && records[i].contentPosY == posY)
+			return true;
+	return false;
+}
+
+
+/*
+- Main function. Runs the test.
+*/
+int main()
+{
+	sf::Sprite sprite;
+	LAYOUT::freeLayout root("root", 0, 0, 800, 600, 0, 0, 800, 600);
+	LAYOUT::snapshotBuffer buffer(&root);
+
+	// 'a' is the first element in the store and 'b' the last one, so removing
+	// 'a' moves 'b' into its index.
+	LAYOUT::spriteElement *a = new LAYOUT::spriteElement(&sprite, "a");
+	LAYOUT::spriteElement others[10];
+	LAYOUT::spriteElement b(&sprite, "b");
+	root.add_element(*a);
+	for (int i = 0 ; i < 10 ; i ++)
+	{
+		others[i].set_content(sprite);
+		root.add_element(others[i]);
+	}
+	root.add_element(b);
+	buffer.publish();
+
+	root.remove_element(*a);
+	buffer.publish();
+
+	// 'b' is flagged as changed before 'a' leaves the store.
+	b.set_content_position(100, 100);
+	delete a;
+	buffer.publish();
+	if (!has_content_at(buffer.acquire(), 100, 100))
+	{
+		printf("FAILED: change before removal not published\n");
+		return 1;
+	}
+
+	for (int i = 0 ; i < 3 ; i ++)
+	{
+		b.set_content_position(300 + i, 300);
+		buffer.publish();
+		if (!has_content_at(buffer.acquire(), 300 + i, 300))
+		{
+			printf("FAILED: change after removal not published\n");
+			return 1;
+		}
+	}
+
+	printf("ok\n");
+	return 0;
+}